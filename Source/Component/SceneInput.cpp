@@ -1,8 +1,12 @@
 #include "SceneInput.h"
-#include <iostream>
 
 #include <include/gl.h>
 #include <Core/Window/WindowObject.h>
+#include <Core/Logging/Log.h>
+#include <Core/GPU/FrameCapture.h>
+#include <Core/Profiling/GpuProfiler.h>
+#include <Core/Profiling/LatencyTracker.h>
+#include <Core/Profiling/Profiler.h>
 
 #include "SimpleScene.h"
 
@@ -23,6 +27,50 @@ void SceneInput::OnKeyPress(int key, int mods)
 	if (key == GLFW_KEY_F5)
 		scene->ReloadShaders();
 
+	// Starts a CPU profile capture, the second press stops it and writes the trace
+	if (key == GLFW_KEY_F7)
+	{
+		if (Profiler::IsEnabled()) {
+			Profiler::SetEnabled(false);
+			Profiler::ExportChromeTrace(PROFILER_TRACE_FILE);
+		}
+		else {
+			Profiler::Clear();
+			Profiler::SetEnabled(true);
+			Log::Info("[Profiler] Capture started, press F7 again to stop");
+		}
+	}
+
+	// GPU pass timings: overlay, window title and per-frame log
+	if (key == GLFW_KEY_F8)
+		GpuProfiler::SetEnabled(!GpuProfiler::IsEnabled());
+
+	// Screenshot of the next frame, written by the capture workers
+	if (key == GLFW_KEY_F9)
+		FrameCapture::Screenshot("Screenshot.png");
+
+	// Raw video of every frame until the second press
+	if (key == GLFW_KEY_F10)
+	{
+		if (FrameCapture::IsRecording())
+			FrameCapture::StopRecording();
+		else
+			FrameCapture::StartRecording("Capture", FrameCapture::Format::RAW_VIDEO);
+	}
+
+	// Input-to-photon latency, the second press prints the percentiles
+	if (key == GLFW_KEY_F11)
+	{
+		if (LatencyTracker::IsEnabled()) {
+			LatencyTracker::PrintReport();
+			LatencyTracker::SetEnabled(false);
+		}
+		else {
+			LatencyTracker::Clear();
+			LatencyTracker::SetEnabled(true);
+		}
+	}
+
 	if (key == GLFW_KEY_ESCAPE)
 		scene->Exit();
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #include "SimpleScene.h"
 
 #include <vector>
-#include <iostream>
 
 #include "CameraInput.h"
 #include "SceneInput.h"
@@ -64,7 +63,7 @@ void SimpleScene::InitResources()
 		shader->AddShader(RESOURCE_PATH::SHADERS + "MVP.Texture.VS.glsl", GL_VERTEX_SHADER);
 		shader->AddShader(RESOURCE_PATH::SHADERS + "Default.FS.glsl", GL_FRAGMENT_SHADER);
 		shader->CreateAndLink();
-		shaders[shader->GetName()] = shader;
+		AddShaderToList(shader);
 	}
 
 	// Create a shader program for drawing vertex colors
@@ -73,7 +72,7 @@ void SimpleScene::InitResources()
 		shader->AddShader(RESOURCE_PATH::SHADERS + "MVP.Texture.VS.glsl", GL_VERTEX_SHADER);
 		shader->AddShader(RESOURCE_PATH::SHADERS + "Color.FS.glsl", GL_FRAGMENT_SHADER);
 		shader->CreateAndLink();
-		shaders[shader->GetName()] = shader;
+		AddShaderToList(shader);
 	}
 
 	// Create a shader program for drawing face polygon with the color of the normal
@@ -82,7 +81,7 @@ void SimpleScene::InitResources()
 		shader->AddShader(RESOURCE_PATH::SHADERS + "MVP.Texture.VS.glsl", GL_VERTEX_SHADER);
 		shader->AddShader(RESOURCE_PATH::SHADERS + "Normals.FS.glsl", GL_FRAGMENT_SHADER);
 		shader->CreateAndLink();
-		shaders[shader->GetName()] = shader;
+		AddShaderToList(shader);
 	}
 
 	// Create a shader program for drawing vertex colors
@@ -91,20 +90,58 @@ void SimpleScene::InitResources()
 		shader->AddShader(RESOURCE_PATH::SHADERS + "MVP.Texture.VS.glsl", GL_VERTEX_SHADER);
 		shader->AddShader(RESOURCE_PATH::SHADERS + "VertexColor.FS.glsl", GL_FRAGMENT_SHADER);
 		shader->CreateAndLink();
-		shaders[shader->GetName()] = shader;
+		AddShaderToList(shader);
 	}
 
+	simpleShader = GetShaderHandle("Simple");
+	colorShader = GetShaderHandle("Color");
+
 	// Default rendering mode will use depth buffer
 	glDepthMask(GL_TRUE);
 	glEnable(GL_DEPTH_TEST);
 }
 
-void SimpleScene::AddMeshToList(Mesh * mesh)
+MeshHandle SimpleScene::AddMeshToList(Mesh * mesh)
 {
-	if (mesh->GetMeshID())
-	{
-		meshes[mesh->GetMeshID()] = mesh;
+	if (!mesh->GetMeshID())
+		return MeshHandle();
+
+	auto it = meshHandles.find(mesh->GetMeshID());
+	if (it != meshHandles.end())
+		meshPool.Remove(it->second);
+
+	MeshHandle handle = meshPool.Add(mesh);
+	meshes[mesh->GetMeshID()] = mesh;
+	meshHandles[mesh->GetMeshID()] = handle;
+	return handle;
+}
+
+ShaderHandle SimpleScene::AddShaderToList(Shader * shader)
+{
+	auto it = shaderHandles.find(shader->GetName());
+	if (it != shaderHandles.end()) {
+		ShaderReloader::Unwatch(shaderPool.Get(it->second));
+		shaderPool.Remove(it->second);
 	}
+
+	// Registered shaders are rebuilt in the background whenever one of their files is saved
+	ShaderReloader::Watch(shader);
+	ShaderHandle handle = shaderPool.Add(shader);
+	shaders[shader->GetName()] = shader;
+	shaderHandles[shader->GetName()] = handle;
+	return handle;
+}
+
+MeshHandle SimpleScene::GetMeshHandle(const std::string & name) const
+{
+	auto it = meshHandles.find(name);
+	return (it != meshHandles.end()) ? it->second : MeshHandle();
+}
+
+ShaderHandle SimpleScene::GetShaderHandle(const std::string & name) const
+{
+	auto it = shaderHandles.find(name);
+	return (it != shaderHandles.end()) ? it->second : ShaderHandle();
 }
 
 void SimpleScene::DrawCoordinatSystem()
@@ -119,7 +156,7 @@ void SimpleScene::DrawCoordinatSystem(const glm::mat4 & viewMatrix, const glm::m
 
 	// Render the coordinate system
 	{
-		Shader *shader = shaders["Color"];
+		Shader *shader = GetShader(colorShader);
 		shader->Use();
 		glUniformMatrix4fv(shader->loc_view_matrix, 1, GL_FALSE, glm::value_ptr(viewMatrix));
 		glUniformMatrix4fv(shader->loc_projection_matrix, 1, GL_FALSE, glm::value_ptr(projectionMaxtix));
@@ -177,7 +214,7 @@ void SimpleScene::RenderMesh(Mesh * mesh, Shader * shader, glm::vec3 position, g
 
 void SimpleScene::RenderMesh(Mesh * mesh, glm::vec3 position, glm::vec3 scale)
 {
-	RenderMesh(mesh, shaders["Simple"], position, scale);
+	RenderMesh(mesh, GetShader(simpleShader), position, scale);
 }
 
 void SimpleScene::RenderMesh2D(Mesh * mesh, Shader * shader, const glm::mat3 &modelMatrix)
@@ -202,7 +239,7 @@ void SimpleScene::RenderMesh2D(Mesh * mesh, Shader * shader, const glm::mat3 &mo
 
 void SimpleScene::RenderMesh2D(Mesh * mesh, const glm::mat3 & modelMatrix, const glm::vec3 & color) const
 {
-	Shader* shader = shaders.at("Color");
+	Shader* shader = GetShader(colorShader);
 
 	if (!mesh || !shader || !shader->program)
 		return;
@@ -240,15 +277,11 @@ void SimpleScene::RenderMesh(Mesh * mesh, Shader * shader, const glm::mat4 & mod
 
 void SimpleScene::ReloadShaders() const
 {
-	cout << endl;
-	cout << "=============================" << endl;
-	cout << "Reloading Shaders" << endl;
-	cout << "=============================" << endl;
-	cout << endl;
+	Log::Info("\n=============================\nReloading Shaders\n=============================\n");
 
 	for (auto &shader : shaders)
 	{
-		shader.second->Reload();
+		ShaderReloader::Reload(shader.second);
 	}
 }
 
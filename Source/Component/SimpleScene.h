@@ -11,6 +11,10 @@ namespace EngineComponents
 }
 
 #include <Core/World.h>
+#include <Core/Managers/ResourcePool.h>
+
+typedef ResourceHandle<Mesh> MeshHandle;
+typedef ResourceHandle<Shader> ShaderHandle;
 
 class SimpleScene : public World
 {
@@ -21,7 +25,16 @@ class SimpleScene : public World
 		~SimpleScene();
 
 	protected:
-		virtual void AddMeshToList(Mesh *mesh);
+		// Registering under an existing name replaces the resource and invalidates the old handle
+		virtual MeshHandle AddMeshToList(Mesh *mesh);
+		virtual ShaderHandle AddShaderToList(Shader *shader);
+
+		// Resolve handles once after loading, per-frame code should only call GetMesh/GetShader with a handle
+		MeshHandle GetMeshHandle(const std::string &name) const;
+		ShaderHandle GetShaderHandle(const std::string &name) const;
+		Mesh* GetMesh(MeshHandle handle) const { return meshPool.Get(handle); }
+		Shader* GetShader(ShaderHandle handle) const { return shaderPool.Get(handle); }
+
 		virtual void DrawCoordinatSystem();
 		virtual void DrawCoordinatSystem(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMaxtix);
 
@@ -44,6 +57,14 @@ class SimpleScene : public World
 		std::unordered_map<std::string, Mesh*> meshes;
 		std::unordered_map<std::string, Shader*> shaders;
 
+	private:
+		ResourcePool<Mesh> meshPool;
+		ResourcePool<Shader> shaderPool;
+		std::unordered_map<std::string, MeshHandle> meshHandles;
+		std::unordered_map<std::string, ShaderHandle> shaderHandles;
+		ShaderHandle simpleShader;
+		ShaderHandle colorShader;
+
 	private:
 		EngineComponents::Camera *camera;
 		InputController *cameraInput;
@@ -1,23 +1,50 @@
 #include "Engine.h"
 
-#include <iostream>
+#include <chrono>
 
 #include <include/gl.h>
 
 using namespace std;
 
 WindowObject* Engine::window = nullptr;
+bool Engine::glfwReady = false;
+
+namespace
+{
+	// Clock used when GLFW could not start (headless without a display)
+	const chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+}
 
 WindowObject* Engine::Init(WindowProperties & props)
 {
+	STARTUP_PHASE("Engine::Init");
+
+	// Everything after this logs without blocking on the console
+	Log::Init();
+
 	/* Initialize the library */
-	if (!glfwInit())
+	// Headless runs carry on without a display, their context comes from EGL
+	StartupReport::BeginPhase("Window and context");
+	glfwReady = glfwInit() == GLFW_TRUE;
+	if (!glfwReady && !props.headless)
 		exit(0);
 
+	Profiler::SetThreadName("Main");
+
 	window = new WindowObject(props);
+	StartupReport::EndPhase();
 
+	StartupReport::BeginPhase("glewInit");
 	glewExperimental = true;
 	GLenum err = glewInit();
+	StartupReport::EndPhase();
+
+	#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// The GL entry points are loaded by then, GLEW only misses GLX which an EGL context never has
+	if (err == GLEW_ERROR_NO_GLX_DISPLAY && window->IsHeadless())
+		err = GLEW_OK;
+	#endif
+
 	if (GLEW_OK != err)
 	{
 		// Serious problem
@@ -28,7 +55,32 @@ WindowObject* Engine::Init(WindowProperties & props)
 		exit(0);
 	}
 
+	if (props.headless)
+		window->InitOffscreenFramebuffer();
+
+	StartupReport::BeginPhase("AssetLoader::Init");
+	AssetLoader::Init();
+	StartupReport::EndPhase();
+
+	StartupReport::BeginPhase("ShaderReloader::Init");
+	ShaderReloader::Init();
+	StartupReport::EndPhase();
+
+	StartupReport::BeginPhase("TextureManager::Init");
 	TextureManager::Init();
+	StartupReport::EndPhase();
+
+	StartupReport::BeginPhase("GpuProfiler::Init");
+	GpuProfiler::Init();
+	StartupReport::EndPhase();
+
+	StartupReport::BeginPhase("LatencyTracker::Init");
+	LatencyTracker::Init();
+	StartupReport::EndPhase();
+
+	StartupReport::BeginPhase("FrameCapture::Init");
+	FrameCapture::Init();
+	StartupReport::EndPhase();
 
 	return window;
 }
@@ -40,12 +92,23 @@ WindowObject* Engine::GetWindow()
 
 void Engine::Exit()
 {
-	cout << "=====================================================" << endl;
-	cout << "Engine closed. Exit" << endl;
+	Log::Info("=====================================================\nEngine closed. Exit");
+	if (Profiler::IsEnabled())
+		Profiler::ExportChromeTrace(PROFILER_TRACE_FILE);
+	FrameCapture::Exit();
+	AssetLoader::Exit();
+	TextureManager::PrintResidency();
+	TextureManager::Exit();
+	ShaderReloader::Exit();
+	GpuProfiler::Exit();
+	LatencyTracker::Exit();
 	glfwTerminate();
+	Log::Exit();
 }
 
 double Engine::GetElapsedTime()
 {
+	if (!glfwReady)
+		return chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
 	return glfwGetTime();
 }
\ No newline at end of file
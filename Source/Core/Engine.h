@@ -12,15 +12,25 @@
 #include <Core/GPU/GPUBuffers.h>
 #include <Core/GPU/Mesh.h>
 #include <Core/GPU/Shader.h>
+#include <Core/GPU/FrameCapture.h>
 #include <Core/GPU/Texture2D.h>
 
+#include <Core/Logging/Log.h>
+
 #include <Core/World.h>
 
 #include <Component/Camera/Camera.h>
 
+#include <Core/Managers/AssetLoader.h>
 #include <Core/Managers/ResourcePath.h>
+#include <Core/Managers/ShaderReloader.h>
 #include <Core/Managers/TextureManager.h>
 
+#include <Core/Profiling/GpuProfiler.h>
+#include <Core/Profiling/LatencyTracker.h>
+#include <Core/Profiling/Profiler.h>
+#include <Core/Profiling/StartupReport.h>
+
 #include <Core/Window/WindowObject.h>
 #include <Core/Window/InputController.h>
 
@@ -38,4 +48,6 @@ class Engine
 
 	private:
 		static WindowObject* window;
+		// False when running headless on a machine without a display
+		static bool glfwReady;
 };
\ No newline at end of file
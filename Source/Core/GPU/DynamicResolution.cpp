@@ -0,0 +1,255 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <include/utils.h>
+
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/GpuProfiler.h>
+#include <Core/Profiling/StartupReport.h>
+
+using namespace std;
+
+namespace
+{
+	// Dead band around the target: above it the scale drops, below the lower edge it rises
+	const double OVER_BUDGET = 1.0;
+	const double UNDER_BUDGET = 0.8;
+	// Weight of the newest frame in the average
+	const double AVERAGE_WEIGHT = 0.1;
+	// Largest change of the scale per adjustment, up is slower than down
+	const float MAX_STEP_DOWN = 0.15f;
+	const float MAX_STEP_UP = 0.05f;
+	// Scales snap to this step so that small timing noise does not resize the target
+	const float SCALE_STEP = 1.0f / 32;
+}
+
+DynamicResolution::DynamicResolution()
+{
+	outputResolution = glm::ivec2(0);
+	renderResolution = glm::ivec2(0);
+	scale = 1;
+	minScale = 0.5f;
+	maxScale = 1;
+	targetMs = 1000.0 / 60;
+	averageMs = -1;
+	cooldown = 0;
+
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+
+	timestamps = false;
+	for (unsigned int i = 0; i < FRAME_LATENCY; i++) {
+		queries[i][0] = queries[i][1] = 0;
+		pending[i] = false;
+	}
+	slot = 0;
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	Release();
+}
+
+bool DynamicResolution::Init(glm::ivec2 outputResolution)
+{
+	Release();
+	this->outputResolution = outputResolution;
+	renderResolution = outputResolution;
+	scale = maxScale;
+
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &colorBuffer);
+	glGenRenderbuffers(1, &depthBuffer);
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_FRAMEBUFFER);
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_RENDERBUFFER, 2);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, outputResolution.x, outputResolution.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, outputResolution.x, outputResolution.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (!complete) {
+		Log::Warn("[DynamicResolution] Render target incomplete, rendering at full resolution");
+		Release();
+		return false;
+	}
+
+	timestamps = false;
+	if (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) {
+		GLint bits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+		timestamps = bits > 0;
+	}
+	if (timestamps) {
+		glGenQueries(2 * FRAME_LATENCY, &queries[0][0]);
+		StartupReport::AddGLObjects(StartupReport::GL_OBJECT_QUERY, 2 * FRAME_LATENCY);
+	}
+	else {
+		Log::Warn("[DynamicResolution] Timer queries not supported, the resolution stays fixed");
+	}
+
+	CheckOpenGLError();
+	return true;
+}
+
+void DynamicResolution::Release()
+{
+	if (framebuffer) {
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &colorBuffer);
+		glDeleteRenderbuffers(1, &depthBuffer);
+		framebuffer = colorBuffer = depthBuffer = 0;
+	}
+
+	if (queries[0][0]) {
+		glDeleteQueries(2 * FRAME_LATENCY, &queries[0][0]);
+		for (unsigned int i = 0; i < FRAME_LATENCY; i++) {
+			queries[i][0] = queries[i][1] = 0;
+			pending[i] = false;
+		}
+	}
+	timestamps = false;
+	averageMs = -1;
+}
+
+bool DynamicResolution::IsInitialized() const
+{
+	return framebuffer != 0;
+}
+
+void DynamicResolution::SetTargetFrameTime(double milliseconds)
+{
+	targetMs = milliseconds;
+}
+
+double DynamicResolution::GetTargetFrameTime() const
+{
+	return targetMs;
+}
+
+void DynamicResolution::SetScaleRange(float minScale, float maxScale)
+{
+	this->minScale = minScale;
+	this->maxScale = std::max(minScale, maxScale);
+	scale = glm::clamp(scale, this->minScale, this->maxScale);
+}
+
+void DynamicResolution::Begin()
+{
+	if (!framebuffer)
+		return;
+
+	ReadBack();
+
+	renderResolution = glm::max(glm::ivec2(glm::vec2(outputResolution) * scale), glm::ivec2(1));
+
+	if (timestamps && !pending[slot])
+		glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+}
+
+void DynamicResolution::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, renderResolution.x, renderResolution.y);
+}
+
+void DynamicResolution::Resolve(GLuint outputFramebuffer)
+{
+	if (!framebuffer)
+		return;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+	glBlitFramebuffer(0, 0, renderResolution.x, renderResolution.y, 0, 0, outputResolution.x, outputResolution.y,
+		GL_COLOR_BUFFER_BIT, renderResolution == outputResolution ? GL_NEAREST : GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+	glViewport(0, 0, outputResolution.x, outputResolution.y);
+	GpuProfiler::CountStateChange(2);
+
+	// A slot still waiting for its results skips this frame instead of overwriting them
+	if (timestamps && !pending[slot]) {
+		glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+		pending[slot] = true;
+	}
+	slot = (slot + 1) % FRAME_LATENCY;
+}
+
+void DynamicResolution::ReadBack()
+{
+	if (!timestamps || !pending[slot])
+		return;
+
+	// The slot about to be reused holds the oldest frame in flight
+	GLuint available = 0;
+	glGetQueryObjectuiv(queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+
+	GLuint64 begin = 0, end = 0;
+	glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &begin);
+	glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &end);
+	pending[slot] = false;
+
+	Adjust((end - begin) / 1e6);
+}
+
+void DynamicResolution::Adjust(double frameMs)
+{
+	averageMs = averageMs < 0 ? frameMs : averageMs + AVERAGE_WEIGHT * (frameMs - averageMs);
+
+	if (cooldown) {
+		cooldown--;
+		return;
+	}
+
+	bool over = averageMs > targetMs * OVER_BUDGET;
+	bool under = averageMs < targetMs * UNDER_BUDGET;
+	if (!over && !(under && scale < maxScale))
+		return;
+
+	// GPU time goes with the pixel count, the square of the scale. Down aims at the target, up only at the middle
+	// of the dead band so that the next frames do not land above it again
+	double goal = over ? targetMs : targetMs * (OVER_BUDGET + UNDER_BUDGET) / 2;
+	float step = static_cast<float>(std::sqrt(goal / std::max(averageMs, 0.01)));
+	step = glm::clamp(step, 1 - MAX_STEP_DOWN, 1 + MAX_STEP_UP);
+
+	float next = std::round(scale * step / SCALE_STEP) * SCALE_STEP;
+	next = glm::clamp(next, minScale, maxScale);
+	if (next == scale)
+		return;
+
+	// The average still holds frames of the old size, start it over from the expected time at the new size
+	averageMs *= (next * next) / (scale * scale);
+	scale = next;
+	cooldown = FRAME_LATENCY * 2;
+}
+
+float DynamicResolution::GetScale() const
+{
+	return scale;
+}
+
+glm::ivec2 DynamicResolution::GetRenderResolution() const
+{
+	return renderResolution;
+}
+
+glm::ivec2 DynamicResolution::GetOutputResolution() const
+{
+	return outputResolution;
+}
+
+double DynamicResolution::GetAverageFrameTime() const
+{
+	return averageMs;
+}
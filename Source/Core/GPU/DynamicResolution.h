@@ -0,0 +1,73 @@
+#pragma once
+
+#include <include/gl.h>
+#include <include/glm.h>
+
+/*
+ *	Offscreen render target whose resolution follows the measured GPU time
+ *	The frame is drawn between Begin() and Resolve(): Bind() makes the scaled target current (viewport included),
+ *	Resolve() upscales it to the output framebuffer with a linear blit. Storage is allocated once at the full output
+ *	size and only the used area changes, so rescaling costs nothing
+ *	GPU time comes from GL_TIMESTAMP queries read FRAME_LATENCY frames late (timestamps do not interfere with the
+ *	GL_TIME_ELAPSED queries of GpuProfiler). The scale moves towards the target on an averaged GPU time, only once
+ *	it left a dead band around the target and after the previous change had time to show, so it does not oscillate
+ */
+
+class DynamicResolution
+{
+	public:
+		static const unsigned int FRAME_LATENCY = 4;
+
+		DynamicResolution();
+		~DynamicResolution();
+
+		DynamicResolution(const DynamicResolution&) = delete;
+		DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+		// Needs the GL context, false when the target could not be created
+		bool Init(glm::ivec2 outputResolution);
+		void Release();
+		bool IsInitialized() const;
+
+		// Frame time the GPU should stay under, in milliseconds
+		void SetTargetFrameTime(double milliseconds);
+		double GetTargetFrameTime() const;
+		// Bounds of the scale applied to both axes
+		void SetScaleRange(float minScale, float maxScale);
+
+		// Starts the GPU timing of a frame and reads back older frames, adjusting the scale
+		void Begin();
+		void Bind() const;
+		// Upscales to the output framebuffer (bound afterwards) and ends the GPU timing of the frame
+		void Resolve(GLuint outputFramebuffer);
+
+		float GetScale() const;
+		glm::ivec2 GetRenderResolution() const;
+		glm::ivec2 GetOutputResolution() const;
+		// Averaged GPU time of the recent frames, negative until the first one was read back
+		double GetAverageFrameTime() const;
+
+	private:
+		void ReadBack();
+		void Adjust(double frameMs);
+
+		glm::ivec2 outputResolution;
+		glm::ivec2 renderResolution;
+		float scale;
+		float minScale;
+		float maxScale;
+		double targetMs;
+		double averageMs;
+		// Frames left before the effect of the last change can be measured
+		unsigned int cooldown;
+
+		GLuint framebuffer;
+		GLuint colorBuffer;
+		GLuint depthBuffer;
+
+		bool timestamps;
+		// Begin / end timestamp of each frame in flight
+		GLuint queries[FRAME_LATENCY][2];
+		bool pending[FRAME_LATENCY];
+		unsigned int slot;
+};
@@ -0,0 +1,302 @@
+#include "FrameCapture.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <stb/stb_image_write.h>
+
+#include <Core/Engine.h>
+#include <Core/Logging/Log.h>
+#include <Core/Threading/ThreadPool.h>
+
+using namespace std;
+
+struct FrameCapture::Recording
+{
+	Recording(const string &prefix, Format format, bool singleFile)
+		: prefix(prefix), format(format), singleFile(singleFile), raw(nullptr), written(0), dropped(0), failed(0)
+	{
+		if (format == Format::RAW_VIDEO) {
+			raw = fopen((prefix + ".rgba").c_str(), "wb");
+			if (!raw)
+				Log::Error("[FrameCapture] Could not write " + prefix + ".rgba");
+		}
+	}
+
+	~Recording()
+	{
+		if (singleFile) {
+			if (written)
+				Log::Info("[Screenshot] Saved " + prefix);
+			else
+				Log::Error("[Screenshot] Could not write " + prefix);
+			return;
+		}
+
+		if (raw)
+			fclose(raw);
+		Log::Info("[FrameCapture] " + prefix, { { "written", written.load() }, { "dropped", dropped.load() },
+			{ "failed", failed.load() } });
+		if (format == Format::RAW_VIDEO && written)
+			Log::Info("\tffmpeg -f rawvideo -pixel_format rgba -video_size " + to_string(resolution.x) + "x" +
+				to_string(resolution.y) + " -i " + prefix + ".rgba " + prefix + ".mp4");
+	}
+
+	// A PNG sequence frame or the screenshot file
+	string GetFileName(unsigned int frameIndex) const
+	{
+		if (singleFile)
+			return prefix;
+		char suffix[16];
+		snprintf(suffix, sizeof(suffix), "_%05u.png", frameIndex);
+		return prefix + suffix;
+	}
+
+	const string prefix;
+	const Format format;
+	const bool singleFile;
+	FILE *raw;
+	glm::ivec2 resolution;
+	atomic<unsigned int> written, dropped, failed;
+};
+
+ThreadPool* FrameCapture::encoders = nullptr;
+ThreadPool* FrameCapture::rawWriter = nullptr;
+FrameCapture::Slot FrameCapture::slots[FrameCapture::PBO_RING];
+unsigned int FrameCapture::nextSlot = 0;
+shared_ptr<FrameCapture::Recording> FrameCapture::recording;
+vector<shared_ptr<FrameCapture::Recording>> FrameCapture::screenshots;
+unsigned int FrameCapture::recordedFrames = 0;
+mutex FrameCapture::buffersMutex;
+vector<vector<unsigned char>*> FrameCapture::freeBuffers;
+atomic<unsigned int> FrameCapture::queuedFrames(0);
+
+void FrameCapture::Init(unsigned int nrThreads)
+{
+	encoders = new ThreadPool(nrThreads);
+	rawWriter = new ThreadPool(1);
+	for (auto &slot : slots) {
+		slot.pbo = 0;
+		slot.size = 0;
+		slot.fence = nullptr;
+		slot.frameIndex = 0;
+	}
+}
+
+void FrameCapture::Exit()
+{
+	if (!encoders)
+		return;
+
+	StopRecording();
+	screenshots.clear();
+
+	// The last frames are worth a wait, nothing is rendered anymore
+	for (auto &slot : slots) {
+		if (slot.fence) {
+			glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			Collect(slot);
+		}
+		if (slot.pbo)
+			glDeleteBuffers(1, &slot.pbo);
+		slot.pbo = 0;
+	}
+
+	// Deleting a pool drops its queued jobs, the last frames would be lost and their buffers leaked
+	encoders->WaitIdle();
+	rawWriter->WaitIdle();
+	delete encoders;
+	delete rawWriter;
+	encoders = rawWriter = nullptr;
+
+	for (auto buffer : freeBuffers)
+		delete buffer;
+	freeBuffers.clear();
+}
+
+bool FrameCapture::StartRecording(const std::string &prefix, Format format)
+{
+	if (!encoders)
+		return false;
+
+	StopRecording();
+	recording = make_shared<Recording>(prefix, format, false);
+	if (format == Format::RAW_VIDEO && !recording->raw) {
+		recording.reset();
+		return false;
+	}
+
+	recordedFrames = 0;
+	Log::Info("[FrameCapture] Recording " + prefix + (format == Format::RAW_VIDEO ? ".rgba" : "_*.png"));
+	return true;
+}
+
+void FrameCapture::StopRecording()
+{
+	// Frames still in flight keep the recording alive until they are written
+	recording.reset();
+}
+
+bool FrameCapture::IsRecording()
+{
+	return recording != nullptr;
+}
+
+void FrameCapture::Screenshot(const std::string &file)
+{
+	if (encoders)
+		screenshots.push_back(make_shared<Recording>(file, Format::PNG_SEQUENCE, true));
+}
+
+void FrameCapture::Update()
+{
+	if (!encoders)
+		return;
+
+	// Oldest first, so that the raw stream gets its frames in order
+	for (unsigned int i = 0; i < PBO_RING; i++) {
+		Slot &slot = slots[(nextSlot + i) % PBO_RING];
+		if (!slot.fence)
+			continue;
+		GLenum status = glClientWaitSync(slot.fence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+			Collect(slot);
+	}
+
+	if (!recording && screenshots.empty())
+		return;
+
+	glm::ivec2 resolution = Engine::GetWindow()->GetResolution();
+	if (recording)
+		Read(resolution, recording);
+	for (auto &screenshot : screenshots)
+		Read(resolution, screenshot);
+	screenshots.clear();
+}
+
+void FrameCapture::Read(glm::ivec2 resolution, const shared_ptr<Recording> &target)
+{
+	unsigned int frameIndex = target->singleFile ? 0 : recordedFrames++;
+
+	// The raw stream has a single frame size
+	if (target->format == Format::RAW_VIDEO) {
+		if (frameIndex == 0)
+			target->resolution = resolution;
+		else if (resolution != target->resolution) {
+			target->dropped++;
+			return;
+		}
+	}
+
+	Slot &slot = slots[nextSlot];
+	if (slot.fence) {
+		// The GPU is more than PBO_RING frames behind, skip this one rather than wait
+		target->dropped++;
+		return;
+	}
+	nextSlot = (nextSlot + 1) % PBO_RING;
+
+	size_t size = static_cast<size_t>(resolution.x) * resolution.y * 4;
+	if (!slot.pbo)
+		glGenBuffers(1, &slot.pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	if (slot.size != size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.size = size;
+	}
+
+	WindowObject *window = Engine::GetWindow();
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, window->GetFramebuffer());
+	if (!window->GetFramebuffer())
+		glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, resolution.x, resolution.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.resolution = resolution;
+	slot.recording = target;
+	slot.frameIndex = frameIndex;
+}
+
+void FrameCapture::Collect(Slot &slot)
+{
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+	shared_ptr<Recording> target = move(slot.recording);
+
+	if (queuedFrames >= MAX_QUEUED_FRAMES) {
+		// The workers fall behind, keep the memory bounded
+		target->dropped++;
+		return;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	const unsigned char *pixels = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+		slot.size, GL_MAP_READ_BIT));
+	if (!pixels) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		target->failed++;
+		return;
+	}
+
+	// OpenGL rows start at the bottom of the image
+	int width = slot.resolution.x, height = slot.resolution.y;
+	size_t stride = static_cast<size_t>(width) * 4;
+	vector<unsigned char> *image = AcquireBuffer(slot.size);
+	for (int y = 0; y < height; y++)
+		memcpy(image->data() + y * stride, pixels + (height - 1 - y) * stride, stride);
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	queuedFrames++;
+	unsigned int frameIndex = slot.frameIndex;
+	if (target->format == Format::RAW_VIDEO)
+	{
+		rawWriter->Enqueue([target, image]() {
+			if (fwrite(image->data(), 1, image->size(), target->raw) == image->size())
+				target->written++;
+			else
+				target->failed++;
+			ReleaseBuffer(image);
+		});
+	}
+	else
+	{
+		encoders->Enqueue([target, image, width, height, frameIndex]() {
+			string file = target->GetFileName(frameIndex);
+			if (stbi_write_png(file.c_str(), width, height, 4, image->data(), width * 4))
+				target->written++;
+			else
+				target->failed++;
+			ReleaseBuffer(image);
+		});
+	}
+}
+
+vector<unsigned char>* FrameCapture::AcquireBuffer(size_t size)
+{
+	vector<unsigned char> *buffer = nullptr;
+	{
+		lock_guard<mutex> lock(buffersMutex);
+		if (!freeBuffers.empty()) {
+			buffer = freeBuffers.back();
+			freeBuffers.pop_back();
+		}
+	}
+
+	if (!buffer)
+		buffer = new vector<unsigned char>();
+	buffer->resize(size);
+	return buffer;
+}
+
+void FrameCapture::ReleaseBuffer(vector<unsigned char> *buffer)
+{
+	{
+		lock_guard<mutex> lock(buffersMutex);
+		freeBuffers.push_back(buffer);
+	}
+	queuedFrames--;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <include/gl.h>
+#include <include/glm.h>
+
+class ThreadPool;
+
+/*
+ *	Asynchronous capture of the window framebuffer
+ *	Update() starts a glReadPixels into one of PBO_RING pixel buffer objects behind a fence and maps the buffers
+ *	whose fence has passed, so the render thread never waits for the GPU. Frames are flipped into pooled memory and
+ *	handed to worker threads: PNG compression runs on a small pool, the raw stream on a single writer that keeps the
+ *	frame order. At most MAX_QUEUED_FRAMES frames wait for the workers; a full ring or a backlog drops the frame
+ *	(counted in the recording summary) instead of adding a frame-time spike
+ */
+
+class FrameCapture
+{
+	public:
+		enum class Format
+		{
+			// prefix_00000.png, prefix_00001.png...
+			PNG_SEQUENCE,
+			// prefix.rgba, top-down RGBA8 frames back to back
+			RAW_VIDEO
+		};
+
+		static const unsigned int PBO_RING = 3;
+		static const unsigned int MAX_QUEUED_FRAMES = 8;
+
+		static void Init(unsigned int nrThreads = 2);
+		// Finishes the frames in flight and waits for the workers, needs the GL context
+		static void Exit();
+
+		// Records every frame from the next one on until StopRecording
+		static bool StartRecording(const std::string &prefix, Format format);
+		static void StopRecording();
+		static bool IsRecording();
+
+		// Saves the next frame as a PNG without waiting for it
+		static void Screenshot(const std::string &file);
+
+		// Render thread, once the frame is drawn and before SwapBuffers
+		static void Update();
+
+	protected:
+		FrameCapture() = delete;
+		~FrameCapture() = delete;
+
+	private:
+		// Shared by the frames of one recording, prints its summary once the last one is written
+		struct Recording;
+
+		struct Slot
+		{
+			GLuint pbo;
+			size_t size;
+			GLsync fence;
+			glm::ivec2 resolution;
+			std::shared_ptr<Recording> recording;
+			unsigned int frameIndex;
+		};
+
+		static void Read(glm::ivec2 resolution, const std::shared_ptr<Recording> &recording);
+		static void Collect(Slot &slot);
+		static std::vector<unsigned char>* AcquireBuffer(size_t size);
+		static void ReleaseBuffer(std::vector<unsigned char> *buffer);
+
+		static ThreadPool *encoders;
+		static ThreadPool *rawWriter;
+		static Slot slots[PBO_RING];
+		static unsigned int nextSlot;
+
+		static std::shared_ptr<Recording> recording;
+		static std::vector<std::shared_ptr<Recording>> screenshots;
+		static unsigned int recordedFrames;
+
+		static std::mutex buffersMutex;
+		static std::vector<std::vector<unsigned char>*> freeBuffers;
+		static std::atomic<unsigned int> queuedFrames;
+};
@@ -1,5 +1,7 @@
 #include "GPUBuffers.h"
 
+#include <Core/Profiling/StartupReport.h>
+
 using namespace std;
 
 enum VERTEX_ATTRIBUTE_LOC
@@ -7,6 +9,7 @@ enum VERTEX_ATTRIBUTE_LOC
 	POS,
 	NORMAL,
 	TEX_COORD,
+	MATERIAL_INDEX,
 };
 
 GPUBuffers::GPUBuffers()
@@ -21,6 +24,8 @@ void GPUBuffers::CreateBuffers(unsigned int size)
 	this->size = size;
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(size, VBO);
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_VERTEX_ARRAY);
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_BUFFER, size);
 }
 
 void GPUBuffers::ReleaseMemory()
@@ -100,6 +105,48 @@ namespace UtilsGPU
 		return buffers;
 	}
 
+	GPUBuffers UploadData(const vector<glm::vec3> &positions,
+					const vector<glm::vec3> &normals,
+					const vector<glm::vec2> &text_coords,
+					const vector<float> &material_indices,
+					const vector<unsigned short> &indices)
+	{
+		// Create the VAO
+		GPUBuffers buffers;
+		buffers.CreateBuffers(5);
+		glBindVertexArray(buffers.VAO);
+
+		// Generate and populate the buffers with vertex attributes and the indices
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO[0]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(positions[0]) * positions.size(), &positions[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOC::POS);
+		glVertexAttribPointer(VERTEX_ATTRIBUTE_LOC::POS, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO[1]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(normals[0]) * normals.size(), &normals[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOC::NORMAL);
+		glVertexAttribPointer(VERTEX_ATTRIBUTE_LOC::NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO[2]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(text_coords[0]) * text_coords.size(), &text_coords[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOC::TEX_COORD);
+		glVertexAttribPointer(VERTEX_ATTRIBUTE_LOC::TEX_COORD, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO[3]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(material_indices[0]) * material_indices.size(), &material_indices[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOC::MATERIAL_INDEX);
+		glVertexAttribPointer(VERTEX_ATTRIBUTE_LOC::MATERIAL_INDEX, 1, GL_FLOAT, GL_FALSE, 0, 0);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.VBO[4]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices[0]) * indices.size(), &indices[0], GL_STATIC_DRAW);
+
+		// Make sure the VAO is not changed from the outside
+		glBindVertexArray(0);
+		CheckOpenGLError();
+
+		return buffers;
+	}
+
 	GPUBuffers UploadData(const std::vector<VertexFormat> &vertices, const std::vector<unsigned short>& indices)
 	{
 		// Create the VAO
@@ -34,6 +34,13 @@ namespace UtilsGPU
 							const std::vector<glm::vec2> &text_coords,
 							const std::vector<unsigned short> &indices);
 
+	// Adds the per-vertex material index used by StaticBatch as attribute 3
+	GPUBuffers UploadData(const std::vector<glm::vec3> &positions,
+							const std::vector<glm::vec3> &normals,
+							const std::vector<glm::vec2> &text_coords,
+							const std::vector<float> &material_indices,
+							const std::vector<unsigned short> &indices);
+
 	GPUBuffers UploadData(const std::vector<VertexFormat> &vertices,
 							const std::vector<unsigned short>& indices);
 }
@@ -1,10 +1,17 @@
 #include "Mesh.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include <include/utils.h>
 
 #include <Core/GPU/GPUBuffers.h>
+#include <Core/GPU/MeshCache.h>
 #include <Core/GPU/Texture2D.h>
+#include <Core/Logging/Log.h>
 #include <Core/Managers/TextureManager.h>
+#include <Core/Profiling/GpuProfiler.h>
+#include <Core/Profiling/StartupReport.h>
 
 using namespace std;
 
@@ -17,10 +24,13 @@ Mesh::Mesh(std::string meshID)
 	useMaterial = true;
 	glDrawMode = GL_TRIANGLES;
 	buffers = new GPUBuffers();
+	indirectBuffer = 0;
 }
 
 Mesh::~Mesh()
 {
+	if (indirectBuffer)
+		glDeleteBuffers(1, &indirectBuffer);
 	ClearData();
 	meshEntries.clear();
 	SAFE_FREE(buffers);
@@ -39,6 +49,8 @@ const char * Mesh::GetMeshID() const
 void Mesh::ClearData()
 {
 	for (unsigned int i = 0 ; i < materials.size() ; i++) {
+		if (materials[i])
+			TextureManager::ReleaseTexture(materials[i]->texture);
 		SAFE_FREE(materials[i]);
 	}
 	positions.clear();
@@ -48,28 +60,56 @@ void Mesh::ClearData()
 }
 
 bool Mesh::LoadMesh(const string& fileLocation, const string& fileName)
+{
+	return ImportMesh(fileLocation, fileName) && UploadMesh();
+}
+
+bool Mesh::ImportMesh(const string& fileLocation, const string& fileName)
 {
 	ClearData();
 	this->fileLocation = fileLocation;
 	string file = (fileLocation + '/' + fileName).c_str();
 
-	Assimp::Importer Importer;
-
 	unsigned int flags = aiProcess_GenSmoothNormals | aiProcess_FlipUVs;
 	if (glDrawMode == GL_TRIANGLES) flags |= aiProcess_Triangulate;
 
+	auto startTime = chrono::high_resolution_clock::now();
+	auto elapsedTime = [&startTime]() {
+		return chrono::duration<float, milli>(chrono::high_resolution_clock::now() - startTime).count();
+	};
+
+	// The baked blob skips Assimp entirely
+	float importTime = 0;
+	if (MeshCache::Read(file, flags, this, importTime)) {
+		Log::Info("\tMESH = " + file + " ..... CACHED", { { "ms", elapsedTime() }, { "assimp_ms", importTime } });
+		return true;
+	}
+
+	Assimp::Importer Importer;
+
+	StartupReport::AddFileRead(file);
 	const aiScene* pScene = Importer.ReadFile(file, flags);
 
 	if (pScene) {
-		return InitFromScene(pScene);
+		bool status = InitFromScene(pScene);
+		importTime = elapsedTime();
+		if (status)
+			MeshCache::Write(file, flags, this, importTime);
+		Log::Info("\tMESH = " + file + " ..... IMPORTED", { { "ms", importTime } });
+		return status;
 	}
 
 	// pScene is freed when returning because of Importer
 
-	printf("Error parsing '%s': '%s'\n", file.c_str(), Importer.GetErrorString());
+	Log::Error("Error parsing '" + file + "'", { { "error", Importer.GetErrorString() } });
 	return false;
 }
 
+bool Mesh::IsLoaded() const
+{
+	return buffers->VAO != 0;
+}
+
 void Mesh::InitFromData()
 {
 	meshEntries.clear();
@@ -171,11 +211,85 @@ bool Mesh::InitFromScene(const aiScene* pScene)
 	if (useMaterial && !InitMaterials(pScene))
 		return false;
 
+	return true;
+}
+
+bool Mesh::UploadMesh()
+{
+	for (auto material : materials)
+	{
+		if (material && !material->textureFile.empty()) {
+			material->texture = TextureManager::LoadTexture(fileLocation, material->textureFile.c_str());
+		}
+	}
+
 	buffers->ReleaseMemory();
 	*buffers = UtilsGPU::UploadData(positions, normals, texCoords, indices);
+	BuildDrawGroups();
 	return buffers->VAO != 0;
 }
 
+void Mesh::BuildDrawGroups()
+{
+	drawGroups.clear();
+	drawCounts.clear();
+	drawOffsets.clear();
+	drawBaseVertices.clear();
+
+	// A single submesh gains nothing over the plain draw in Render
+	if (meshEntries.size() < 2)
+		return;
+
+	vector<unsigned int> order(meshEntries.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+		order[i] = i;
+
+	// Without materials every submesh shares the same state and a single group is enough
+	if (useMaterial) {
+		stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+			return meshEntries[a].materialIndex < meshEntries[b].materialIndex;
+		});
+	}
+
+	vector<DrawElementsIndirectCommand> commands;
+	for (auto i : order)
+	{
+		const MeshEntry &entry = meshEntries[i];
+		unsigned int materialIndex = useMaterial ? entry.materialIndex : INVALID_MATERIAL;
+		if (drawGroups.empty() || drawGroups.back().materialIndex != materialIndex) {
+			DrawGroup group;
+			group.materialIndex = materialIndex;
+			group.firstDraw = static_cast<unsigned int>(commands.size());
+			group.nrDraws = 0;
+			drawGroups.push_back(group);
+		}
+		drawGroups.back().nrDraws++;
+
+		DrawElementsIndirectCommand command;
+		command.count = entry.nrIndices;
+		command.instanceCount = 1;
+		command.firstIndex = entry.baseIndex;
+		command.baseVertex = entry.baseVertex;
+		command.baseInstance = 0;
+		commands.push_back(command);
+
+		drawCounts.push_back(entry.nrIndices);
+		drawOffsets.push_back((void*)(sizeof(unsigned short) * entry.baseIndex));
+		drawBaseVertices.push_back(entry.baseVertex);
+	}
+
+	if (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect)
+	{
+		if (!indirectBuffer) {
+			glGenBuffers(1, &indirectBuffer);
+			StartupReport::AddGLObjects(StartupReport::GL_OBJECT_BUFFER);
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * commands.size(), commands.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
+
 void Mesh::InitMesh(const aiMesh* paiMesh)
 {
 	const aiVector3D Zero3D(0.0f, 0.0f, 0.0f);
@@ -217,7 +331,7 @@ bool Mesh::InitMaterials(const aiScene* pScene)
 			aiString Path;
 			if (pMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &Path, NULL, NULL, NULL, NULL, NULL) == AI_SUCCESS)
 			{
-				materials[i]->texture = TextureManager::LoadTexture(fileLocation, Path.data);
+				materials[i]->textureFile = Path.data;
 			}
 		}
 
@@ -234,7 +348,6 @@ bool Mesh::InitMaterials(const aiScene* pScene)
 			memcpy(&materials[i]->emissive, &color, sizeof(color));
 	}
 
-	CheckOpenGLError();
 	return ret;
 }
 
@@ -253,23 +366,64 @@ void Mesh::UseMaterials(bool value)
 	useMaterial = value;
 }
 
+void Mesh::BindMaterial(unsigned int materialIndex) const
+{
+	// Textures still being decoded resolve to the default texture
+	if (materialIndex != INVALID_MATERIAL && materials[materialIndex] && materials[materialIndex]->texture &&
+		materials[materialIndex]->texture->GetTextureID())
+	{
+		(materials[materialIndex]->texture)->BindToTextureUnit(GL_TEXTURE0);
+	}
+	else {
+		TextureManager::GetTexture(static_cast<unsigned int>(0))->BindToTextureUnit(GL_TEXTURE0);
+	}
+}
+
 void Mesh::Render() const
 {
+	if (!IsLoaded())
+		return;
+
 	glBindVertexArray(buffers->VAO);
-	for (unsigned int i = 0; i < meshEntries.size(); i++)
+	GpuProfiler::CountStateChange();
+
+	if (!drawGroups.empty())
 	{
-		if (useMaterial)
+		if (indirectBuffer)
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+
+		for (auto &group : drawGroups)
 		{
-			auto materialIndex = meshEntries[i].materialIndex;
-			if (materialIndex != INVALID_MATERIAL && materials[materialIndex]->texture)
-			{
-				(materials[materialIndex]->texture)->BindToTextureUnit(GL_TEXTURE0);
+			if (useMaterial) {
+				BindMaterial(group.materialIndex);
+				GpuProfiler::CountStateChange();
+			}
+
+			GpuProfiler::CountMultiDraw(glDrawMode, &drawCounts[group.firstDraw], group.nrDraws);
+			if (indirectBuffer) {
+				glMultiDrawElementsIndirect(glDrawMode, GL_UNSIGNED_SHORT,
+					(void*)(sizeof(DrawElementsIndirectCommand) * group.firstDraw), group.nrDraws, 0);
 			}
 			else {
-				TextureManager::GetTexture(static_cast<unsigned int>(0))->BindToTextureUnit(GL_TEXTURE0);
+				glMultiDrawElementsBaseVertex(glDrawMode, &drawCounts[group.firstDraw], GL_UNSIGNED_SHORT,
+					&drawOffsets[group.firstDraw], group.nrDraws, &drawBaseVertices[group.firstDraw]);
 			}
 		}
 
+		if (indirectBuffer)
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindVertexArray(0);
+		return;
+	}
+
+	for (unsigned int i = 0; i < meshEntries.size(); i++)
+	{
+		if (useMaterial) {
+			BindMaterial(meshEntries[i].materialIndex);
+			GpuProfiler::CountStateChange();
+		}
+
+		GpuProfiler::CountDraw(glDrawMode, meshEntries[i].nrIndices);
 		glDrawElementsBaseVertex(glDrawMode, meshEntries[i].nrIndices,
 			GL_UNSIGNED_SHORT, (void*)(sizeof(unsigned short) * meshEntries[i].baseIndex),
 			meshEntries[i].baseVertex);
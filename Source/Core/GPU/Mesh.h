@@ -36,6 +36,7 @@ struct Material
 {
 	Material()
 	{
+		shininess = 0;
 		texture = nullptr;
 	}
 
@@ -45,6 +46,8 @@ struct Material
 	glm::vec4 emissive;
 	float shininess;
 
+	// Diffuse texture file, relative to the mesh location
+	std::string textureFile;
 	Texture2D* texture;
 };
 
@@ -65,8 +68,20 @@ struct MeshEntry
 	unsigned int materialIndex;
 };
 
+// Record layout of GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	unsigned int count;
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance;
+};
+
 class Mesh
 {
+	friend class MeshCache;
+	friend class StaticBatch;
 	typedef unsigned int GLenum;
 
 	public:
@@ -95,6 +110,16 @@ class Mesh
 
 		bool LoadMesh(const std::string& fileLocation, const std::string& fileName);
 
+		// CPU half of LoadMesh (cache or Assimp import), does not touch the OpenGL context
+		// and can run on a worker thread
+		bool ImportMesh(const std::string& fileLocation, const std::string& fileName);
+
+		// GPU half of LoadMesh: loads the material textures and uploads the CPU data
+		bool UploadMesh();
+
+		// True once the GPU buffers exist. Until then the CPU data may still be written by a loader thread
+		bool IsLoaded() const;
+
 		void UseMaterials(bool value);
 
 		// GL_POINTS, GL_TRIANGLES, GL_LINES, GL_LINE_STRIP, GL_LINE_LOOP, GL_LINE_STRIP_ADJACENCY, GL_LINES_ADJACENCY,
@@ -110,6 +135,11 @@ class Mesh
 	protected:
 		void InitFromData();
 
+		// Groups the submeshes by material so Render binds each texture once and submits the group with one multi-draw
+		// (glMultiDrawElementsIndirect when GL 4.3 / ARB_multi_draw_indirect is available)
+		void BuildDrawGroups();
+		void BindMaterial(unsigned int materialIndex) const;
+
 		void InitMesh(const aiMesh* paiMesh);
 		bool InitMaterials(const aiScene* pScene);
 		bool InitFromScene(const aiScene* pScene);
@@ -135,4 +165,17 @@ class Mesh
 
 		std::vector<MeshEntry> meshEntries;
 		std::vector<Material*> materials;
+
+		struct DrawGroup
+		{
+			unsigned int materialIndex;
+			unsigned int firstDraw;
+			unsigned int nrDraws;
+		};
+
+		std::vector<DrawGroup> drawGroups;
+		std::vector<int> drawCounts;
+		std::vector<const void*> drawOffsets;
+		std::vector<int> drawBaseVertices;
+		unsigned int indirectBuffer;
 };
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <include/hash.h>
+#include <include/mapped_file.h>
+#include <include/temp_file.h>
+
+#include <Core/GPU/Mesh.h>
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/StartupReport.h>
+
+using namespace std;
+
+namespace
+{
+	const char MAGIC[4] = { 'M', 'S', 'H', 'C' };
+
+	// All records are 4 byte aligned so the arrays can be read straight from the mapping
+	struct BlobHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t importFlags;
+		uint32_t useMaterial;
+		uint32_t nrVertices;
+		uint32_t nrIndices;
+		uint32_t nrEntries;
+		uint32_t nrMaterials;
+		float importTime;
+		uint32_t reserved;
+	};
+
+	struct EntryRecord
+	{
+		uint32_t nrIndices;
+		uint32_t baseVertex;
+		uint32_t baseIndex;
+		uint32_t materialIndex;
+	};
+
+	struct MaterialRecord
+	{
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec4 specular;
+		glm::vec4 emissive;
+		float shininess;
+		uint32_t present;
+		char textureFile[256];
+	};
+
+	// Material libraries named by the "mtllib" lines of an .obj, resolved next to it like Assimp does
+	vector<string> GetMaterialLibraries(const string &file, const unsigned char *data, size_t size)
+	{
+		vector<string> libraries;
+		if (file.size() < 4 || file.compare(file.size() - 4, 4, ".obj") != 0)
+			return libraries;
+
+		size_t separator = file.find_last_of("/\\");
+		string directory = (separator == string::npos) ? "" : file.substr(0, separator + 1);
+
+		const char *text = reinterpret_cast<const char*>(data);
+		for (size_t start = 0; start < size;)
+		{
+			size_t end = start;
+			while (end < size && text[end] != '\n')
+				end++;
+
+			string line(text + start, end - start);
+			start = end + 1;
+			size_t keyword = line.find_first_not_of(" \t");
+			if (keyword == string::npos || line.compare(keyword, 7, "mtllib ") != 0)
+				continue;
+
+			size_t first = line.find_first_not_of(" \t", keyword + 7);
+			size_t last = line.find_last_not_of(" \t\r");
+			if (first != string::npos && last >= first)
+				libraries.push_back(directory + line.substr(first, last - first + 1));
+		}
+		return libraries;
+	}
+
+	// The source and every material library it pulls in, the baked materials and texture paths come from those
+	bool HashSources(const string &file, uint64_t &hash)
+	{
+		MappedFile source;
+		if (!source.Open(file.c_str()))
+			return false;
+		StartupReport::AddBytesRead(source.GetSize());
+		hash = HashFNV1a(source.GetData(), source.GetSize());
+
+		for (auto &library : GetMaterialLibraries(file, source.GetData(), source.GetSize()))
+		{
+			// A missing library imports without materials, its name still keys the blob so that adding it rebakes
+			size_t size = 0;
+			hash = HashFNV1a(library, hash);
+			if (HashFile(library, hash, hash, &size))
+				StartupReport::AddBytesRead(size);
+		}
+		return true;
+	}
+
+	template <typename T>
+	const T* ReadArray(const unsigned char *&cursor, size_t count)
+	{
+		auto data = reinterpret_cast<const T*>(cursor);
+		cursor += sizeof(T) * count;
+		return data;
+	}
+
+	template <typename T>
+	void WriteArray(ofstream &out, const T *data, size_t count)
+	{
+		if (count)
+			out.write(reinterpret_cast<const char*>(data), sizeof(T) * count);
+	}
+}
+
+string MeshCache::GetCacheFile(const string &file)
+{
+	return file + ".meshcache";
+}
+
+bool MeshCache::Read(const string &file, unsigned int importFlags, Mesh *mesh, float &importTime)
+{
+	MappedFile blob;
+	if (!blob.Open(GetCacheFile(file).c_str()) || blob.GetSize() < sizeof(BlobHeader))
+		return false;
+	StartupReport::AddBytesRead(blob.GetSize());
+
+	const BlobHeader *header = reinterpret_cast<const BlobHeader*>(blob.GetData());
+	if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) || header->version != VERSION)
+		return false;
+
+	if (header->importFlags != importFlags || header->useMaterial != (mesh->useMaterial ? 1u : 0u))
+		return false;
+
+	size_t expectedSize = sizeof(BlobHeader)
+		+ header->nrEntries * sizeof(EntryRecord)
+		+ header->nrMaterials * sizeof(MaterialRecord)
+		+ header->nrVertices * (2 * sizeof(glm::vec3) + sizeof(glm::vec2))
+		+ header->nrIndices * sizeof(unsigned short);
+	if (blob.GetSize() != expectedSize)
+		return false;
+
+	uint64_t sourceHash;
+	if (!HashSources(file, sourceHash) || sourceHash != header->sourceHash)
+		return false;
+
+	const unsigned char *cursor = blob.GetData() + sizeof(BlobHeader);
+	auto entries = ReadArray<EntryRecord>(cursor, header->nrEntries);
+	auto materials = ReadArray<MaterialRecord>(cursor, header->nrMaterials);
+	auto positions = ReadArray<glm::vec3>(cursor, header->nrVertices);
+	auto normals = ReadArray<glm::vec3>(cursor, header->nrVertices);
+	auto texCoords = ReadArray<glm::vec2>(cursor, header->nrVertices);
+	auto indices = ReadArray<unsigned short>(cursor, header->nrIndices);
+
+	mesh->meshEntries.resize(header->nrEntries);
+	for (unsigned int i = 0; i < header->nrEntries; i++)
+	{
+		mesh->meshEntries[i].nrIndices = static_cast<unsigned short>(entries[i].nrIndices);
+		mesh->meshEntries[i].baseVertex = static_cast<unsigned short>(entries[i].baseVertex);
+		mesh->meshEntries[i].baseIndex = static_cast<unsigned short>(entries[i].baseIndex);
+		mesh->meshEntries[i].materialIndex = entries[i].materialIndex;
+	}
+
+	mesh->materials.resize(header->nrMaterials);
+	for (unsigned int i = 0; i < header->nrMaterials; i++)
+	{
+		if (!materials[i].present)
+			continue;
+
+		Material *material = new Material();
+		material->ambient = materials[i].ambient;
+		material->diffuse = materials[i].diffuse;
+		material->specular = materials[i].specular;
+		material->emissive = materials[i].emissive;
+		material->shininess = materials[i].shininess;
+		material->textureFile = string(materials[i].textureFile, strnlen(materials[i].textureFile, sizeof(materials[i].textureFile)));
+		mesh->materials[i] = material;
+	}
+
+	mesh->positions.assign(positions, positions + header->nrVertices);
+	mesh->normals.assign(normals, normals + header->nrVertices);
+	mesh->texCoords.assign(texCoords, texCoords + header->nrVertices);
+	mesh->indices.assign(indices, indices + header->nrIndices);
+
+	importTime = header->importTime;
+	return true;
+}
+
+bool MeshCache::Write(const string &file, unsigned int importFlags, const Mesh *mesh, float importTime)
+{
+	BlobHeader header{};
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.importFlags = importFlags;
+	header.useMaterial = mesh->useMaterial ? 1 : 0;
+	header.nrVertices = static_cast<uint32_t>(mesh->positions.size());
+	header.nrIndices = static_cast<uint32_t>(mesh->indices.size());
+	header.nrEntries = static_cast<uint32_t>(mesh->meshEntries.size());
+	header.nrMaterials = static_cast<uint32_t>(mesh->materials.size());
+	header.importTime = importTime;
+
+	if (!HashSources(file, header.sourceHash))
+		return false;
+
+	// Only meshes with the full attribute set can be baked
+	if (mesh->normals.size() != header.nrVertices || mesh->texCoords.size() != header.nrVertices)
+		return false;
+
+	vector<EntryRecord> entries(header.nrEntries);
+	for (unsigned int i = 0; i < header.nrEntries; i++)
+	{
+		entries[i].nrIndices = mesh->meshEntries[i].nrIndices;
+		entries[i].baseVertex = mesh->meshEntries[i].baseVertex;
+		entries[i].baseIndex = mesh->meshEntries[i].baseIndex;
+		entries[i].materialIndex = mesh->meshEntries[i].materialIndex;
+	}
+
+	vector<MaterialRecord> materials(header.nrMaterials);
+	for (unsigned int i = 0; i < header.nrMaterials; i++)
+	{
+		const Material *material = mesh->materials[i];
+		if (!material)
+			continue;
+
+		// A cut path would load without its texture, the mesh is imported in full every time instead
+		if (material->textureFile.size() >= sizeof(materials[i].textureFile)) {
+			Log::Warn("[MeshCache] Texture path too long, not baking " + file, { { "texture", material->textureFile } });
+			return false;
+		}
+
+		materials[i].ambient = material->ambient;
+		materials[i].diffuse = material->diffuse;
+		materials[i].specular = material->specular;
+		materials[i].emissive = material->emissive;
+		materials[i].shininess = material->shininess;
+		materials[i].present = 1;
+		memcpy(materials[i].textureFile, material->textureFile.c_str(), material->textureFile.size());
+	}
+
+	// Write to a temporary file first so a partially written blob is never picked up
+	string cacheFile = GetCacheFile(file);
+	string tempFile = MakeTempFileName(cacheFile);
+	{
+		ofstream out(tempFile.c_str(), ios::out | ios::binary | ios::trunc);
+		if (!out.good())
+			return false;
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		WriteArray(out, entries.data(), entries.size());
+		WriteArray(out, materials.data(), materials.size());
+		WriteArray(out, mesh->positions.data(), mesh->positions.size());
+		WriteArray(out, mesh->normals.data(), mesh->normals.size());
+		WriteArray(out, mesh->texCoords.data(), mesh->texCoords.size());
+		WriteArray(out, mesh->indices.data(), mesh->indices.size());
+
+		if (!out.good()) {
+			out.close();
+			remove(tempFile.c_str());
+			return false;
+		}
+	}
+
+	return CommitTempFile(tempFile, cacheFile);
+}
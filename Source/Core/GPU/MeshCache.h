@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+
+class Mesh;
+
+/*
+ *	Baked binary copy of an imported mesh, stored next to the source as "<file>.meshcache"
+ *	The blob holds the vertex/index arrays, the MeshEntry table and the material data,
+ *	and is only used when the hash of the source and of its .mtl libraries and the Assimp import flags still match
+ */
+
+class MeshCache
+{
+	public:
+		// Bump whenever the blob layout or the import code changes
+		static const unsigned int VERSION = 2;
+
+		// Fills the CPU side of the mesh from the cache. Returns false on miss or stale blob
+		// importTime receives the Assimp import time (ms) measured when the blob was baked
+		static bool Read(const std::string &file, unsigned int importFlags, Mesh *mesh, float &importTime);
+
+		// Bakes the CPU side of a freshly imported mesh. importTime (ms) is kept for the load report
+		static bool Write(const std::string &file, unsigned int importFlags, const Mesh *mesh, float importTime);
+
+		static std::string GetCacheFile(const std::string &file);
+
+	protected:
+		MeshCache() = delete;
+		~MeshCache() = delete;
+};
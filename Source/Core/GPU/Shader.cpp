@@ -1,20 +1,54 @@
 #include "Shader.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
-#include <iostream>
+#include <sstream>
 #include <include/gl.h>
+#include <include/hash.h>
+
+#include <Core/GPU/ShaderCache.h>
+#include <Core/Logging/Log.h>
+#include <Core/Managers/ShaderReloader.h>
+#include <Core/Profiling/StartupReport.h>
 
 using namespace std;
 
+// Guards against include cycles
+#define MAX_INCLUDE_DEPTH	16
+
+namespace
+{
+	// Driver logs can be long, one log line per line keeps them whole
+	void LogErrorLines(const string &title, const char *text)
+	{
+		Log::Error(title);
+		istringstream lines(text);
+		string line;
+		while (getline(lines, line))
+			if (!line.empty())
+				Log::Error("\t" + line);
+	}
+}
+
 Shader::Shader(const char * name)
 {
 	program = 0;
+	reloadStage = ReloadStage::NONE;
+	reloadProgram = 0;
+	reloadKey = 0;
 	shaderName = string(name);
 	shaderFiles.reserve(5);
 }
 
 Shader::~Shader()
 {
+	for (auto &variant : variants)
+		delete variant.second;
+
+	ShaderReloader::Unwatch(this);
+	CancelReload();
 	glDeleteProgram(program);
 }
 
@@ -47,6 +81,117 @@ unsigned int Shader::Reload()
 	return CreateAndLink();
 }
 
+void Shader::ReloadAsync()
+{
+	CancelReload();
+
+	vector<string> sources;
+	if (!ReadSources(sources, reloadKey)) {
+		Log::Error("\tPROGRAM = " + shaderName + " ..... RELOAD FAILED");
+		return;
+	}
+
+	// Only issue the work here, the status is queried in later frames by UpdateReload
+	for (size_t i = 0; i < shaderFiles.size(); i++) {
+		const char *shader_code_ptr = sources[i].c_str();
+		const int shader_code_size = (int) sources[i].size();
+
+		GLuint glShaderObject = glCreateShader(shaderFiles[i].type);
+		glShaderSource(glShaderObject, 1, &shader_code_ptr, &shader_code_size);
+		glCompileShader(glShaderObject);
+		reloadShaders.push_back(glShaderObject);
+	}
+	reloadStage = ReloadStage::COMPILING;
+}
+
+bool Shader::UpdateReload()
+{
+	if (reloadStage == ReloadStage::NONE)
+		return false;
+
+	// Without parallel shader compile the status queries below wait for the driver
+	if (reloadStage == ReloadStage::COMPILING)
+	{
+		if (GLEW_ARB_parallel_shader_compile) {
+			for (auto shader : reloadShaders) {
+				GLint completed = GL_FALSE;
+				glGetShaderiv(shader, GL_COMPLETION_STATUS_ARB, &completed);
+				if (!completed)
+					return true;
+			}
+		}
+
+		for (size_t i = 0; i < reloadShaders.size(); i++) {
+			GLint compileResult = GL_FALSE;
+			glGetShaderiv(reloadShaders[i], GL_COMPILE_STATUS, &compileResult);
+			if (compileResult == GL_FALSE) {
+				Log::Error("\tFILE = " + shaderFiles[i].file);
+				LogCompileErrors(reloadShaders[i], shaderFiles[i].type);
+				Log::Error("\tPROGRAM = " + shaderName + " ..... RELOAD FAILED, keeping the previous program");
+				CancelReload();
+				return false;
+			}
+		}
+
+		reloadProgram = glCreateProgram();
+		if (ShaderCache::IsSupported())
+			glProgramParameteri(reloadProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		for (auto shader : reloadShaders)
+			glAttachShader(reloadProgram, shader);
+		glLinkProgram(reloadProgram);
+
+		reloadStage = ReloadStage::LINKING;
+		return true;
+	}
+
+	if (GLEW_ARB_parallel_shader_compile) {
+		GLint completed = GL_FALSE;
+		glGetProgramiv(reloadProgram, GL_COMPLETION_STATUS_ARB, &completed);
+		if (!completed)
+			return true;
+	}
+
+	GLint linkResult = GL_FALSE;
+	glGetProgramiv(reloadProgram, GL_LINK_STATUS, &linkResult);
+	if (linkResult == GL_FALSE) {
+		LogLinkErrors(reloadProgram);
+		Log::Error("\tPROGRAM = " + shaderName + " ..... RELOAD FAILED, keeping the previous program");
+		CancelReload();
+		return false;
+	}
+
+	// Swap between frames, draws never see a half built program
+	glDeleteProgram(program);
+	program = reloadProgram;
+	reloadProgram = 0;
+	CancelReload();
+
+	string cacheFile = GetCacheName();
+	if (ShaderCache::Claim(cacheFile, shaderName))
+		ShaderCache::Write(cacheFile, reloadKey, program);
+	Log::Info("\tPROGRAM = " + shaderName + " ..... RELOADED");
+
+	glUseProgram(program);
+	GetUniforms();
+	for (auto Observer : loadObservers) {
+		Observer();
+	}
+	return false;
+}
+
+void Shader::CancelReload()
+{
+	for (auto shader : reloadShaders)
+		glDeleteShader(shader);
+	reloadShaders.clear();
+
+	if (reloadProgram) {
+		glDeleteProgram(reloadProgram);
+		reloadProgram = 0;
+	}
+	reloadStage = ReloadStage::NONE;
+}
+
 void Shader::BindTexturesUnits()
 {
 	for (int i = 0; i < MAX_2D_TEXTURES; i++) {
@@ -65,6 +210,28 @@ void Shader::OnLoad(function<void()> onLoad)
 	loadObservers.push_back(onLoad);
 }
 
+void Shader::SetUniformBlockBinding(const string &blockName, GLuint binding)
+{
+	blockBindings.push_back(make_pair(blockName, binding));
+
+	if (program) {
+		GLuint block = glGetUniformBlockIndex(program, blockName.c_str());
+		if (block != GL_INVALID_INDEX)
+			glUniformBlockBinding(program, block, binding);
+	}
+	for (auto &variant : variants)
+		variant.second->SetUniformBlockBinding(blockName, binding);
+}
+
+void Shader::BindUniformBlocks()
+{
+	for (auto &blockBinding : blockBindings) {
+		GLuint block = glGetUniformBlockIndex(program, blockBinding.first.c_str());
+		if (block != GL_INVALID_INDEX)
+			glUniformBlockBinding(program, block, blockBinding.second);
+	}
+}
+
 void Shader::GetUniforms()
 {
 	// MVP
@@ -99,6 +266,7 @@ void Shader::GetUniforms()
 	text_color = GetUniformLocation("text_color");
 
 	BindTexturesUnits();
+	BindUniformBlocks();
 
 	CheckOpenGLError();
 }
@@ -113,34 +281,56 @@ void Shader::AddShader(const string & shaderFile, GLenum shaderType)
 
 unsigned int Shader::CreateAndLink()
 {
-	vector<unsigned int> shaders;
+	if (shaderFiles.empty())
+		return 0;
 
-	// Compile shaders
-	for (auto S : shaderFiles) {
-		auto shaderID = Shader::CreateShader(S.file, S.type);
-		if (shaderID) {
-			shaders.push_back(shaderID);
-		}
-		else {
-			return 0;
-		}
-	}
+	auto startTime = chrono::high_resolution_clock::now();
 
-	// Create Program and Link
-	if (shaders.size()) {
-		program = Shader::CreateProgram(shaders);
+	vector<string> sources;
+	uint64_t programKey;
+	if (!ReadSources(sources, programKey))
+		terminate();
+
+	string cacheFile = GetCacheName();
+	if (!ShaderCache::Claim(cacheFile, shaderName))
+		cacheFile.clear();
+	program = cacheFile.empty() ? 0 : ShaderCache::Read(cacheFile, programKey);
+	bool cached = (program != 0);
+
+	if (!cached)
+	{
+		vector<unsigned int> shaders;
 
-		if (program)
-		{
-			glUseProgram(program);
-			GetUniforms();
-			for (auto Observer : loadObservers) {
-				Observer();
+		// Compile shaders
+		for (size_t i = 0; i < shaderFiles.size(); i++) {
+			auto shaderID = Shader::CreateShader(shaderFiles[i].file, sources[i], shaderFiles[i].type);
+			if (shaderID) {
+				shaders.push_back(shaderID);
+			}
+			else {
+				return 0;
 			}
-			return program;
 		}
+
+		// Create Program and Link
+		program = Shader::CreateProgram(shaders);
+		if (program && !cacheFile.empty())
+			ShaderCache::Write(cacheFile, programKey, program);
 	}
-	return 0;
+
+	if (!program)
+		return 0;
+
+	chrono::duration<double, milli> buildTime = chrono::high_resolution_clock::now() - startTime;
+	ShaderCache::AddBuildTime(cached, buildTime.count());
+	Log::Info("\tPROGRAM = " + shaderName + " ..... " + (cached ? "CACHED" : "LINKED"), { { "ms", buildTime.count() } });
+
+	glUseProgram(program);
+	GetUniforms();
+	for (auto Observer : loadObservers) {
+		Observer();
+	}
+	return program;
 }
 
 void Shader::ClearShaders()
@@ -148,35 +338,182 @@ void Shader::ClearShaders()
 	shaderFiles.clear();
 }
 
-unsigned int Shader::CreateShader(const string &shaderFile, GLenum shaderType)
+void Shader::AddDefine(const string &name, const string &value)
+{
+	defines.push_back(make_pair(name, value));
+}
+
+Shader* Shader::GetVariant(vector<string> variantDefines)
+{
+	sort(variantDefines.begin(), variantDefines.end());
+	variantDefines.erase(unique(variantDefines.begin(), variantDefines.end()), variantDefines.end());
+
+	string key;
+	for (auto &define : variantDefines)
+		key += (key.empty() ? "" : ",") + define;
+
+	auto it = variants.find(key);
+	if (it != variants.end())
+		return it->second;
+
+	// Built once per define set, later requests share the program
+	Shader *variant = new Shader((shaderName + "[" + key + "]").c_str());
+	variant->shaderFiles = shaderFiles;
+	variant->defines = defines;
+	variant->blockBindings = blockBindings;
+	for (auto &define : variantDefines)
+		variant->AddDefine(define);
+	variant->CreateAndLink();
+	ShaderReloader::Watch(variant);
+
+	variants[key] = variant;
+	return variant;
+}
+
+vector<string> Shader::GetShaderFiles() const
+{
+	vector<string> files;
+	for (auto &S : shaderFiles)
+		files.push_back(S.file);
+	files.insert(files.end(), includedFiles.begin(), includedFiles.end());
+	return files;
+}
+
+string Shader::GetCacheName() const
+{
+	// Programs sharing a vertex shader, and variants of the same sources, each need their own program binary
+	uint64_t programHash = FNV1A_64_SEED;
+	for (auto &S : shaderFiles) {
+		programHash = HashFNV1a(&S.type, sizeof(GLenum), programHash);
+		programHash = HashFNV1a(S.file, programHash);
+	}
+	for (auto &define : defines) {
+		programHash = HashFNV1a(define.first, programHash);
+		programHash = HashFNV1a(define.second, programHash);
+	}
+
+	char suffix[20];
+	sprintf(suffix, ".%016llx", static_cast<unsigned long long>(programHash));
+	return shaderFiles[0].file + suffix;
+}
+
+bool Shader::ReadSources(vector<string> &sources, uint64_t &programKey)
+{
+	// The program key covers the type and the fully preprocessed source of every stage
+	sources.assign(shaderFiles.size(), string());
+	includedFiles.clear();
+	programKey = FNV1A_64_SEED;
+	for (size_t i = 0; i < shaderFiles.size(); i++) {
+		if (!Shader::PreprocessFile(shaderFiles[i].file, sources[i], includedFiles, 0))
+			return false;
+		InjectDefines(sources[i]);
+		programKey = HashFNV1a(&shaderFiles[i].type, sizeof(GLenum), programKey);
+		programKey = HashFNV1a(sources[i], programKey);
+	}
+	return true;
+}
+
+bool Shader::PreprocessFile(const string &shaderFile, string &output, vector<string> &includes, unsigned int depth)
 {
+	if (depth > MAX_INCLUDE_DEPTH) {
+		Log::Error("\tToo many nested includes: " + shaderFile);
+		return false;
+	}
+
 	string shader_code;
+	if (!Shader::ReadShaderFile(shaderFile, shader_code))
+		return false;
+
+	size_t separator = shaderFile.find_last_of("/\\");
+	string directory = (separator == string::npos) ? "" : shaderFile.substr(0, separator + 1);
+
+	// #include "file" is resolved relative to the including file, #line keeps compile errors pointing at the right line
+	istringstream lines(shader_code);
+	string line;
+	unsigned int lineNumber = 0;
+	while (getline(lines, line))
+	{
+		lineNumber++;
+		size_t start = line.find_first_not_of(" \t");
+		if (start == string::npos || line.compare(start, 8, "#include") != 0) {
+			output += line;
+			output += '\n';
+			continue;
+		}
+
+		size_t open = line.find('"', start);
+		size_t close = (open == string::npos) ? open : line.find('"', open + 1);
+		if (close == string::npos) {
+			Log::Error("\tMalformed #include in " + shaderFile + ":" + to_string(lineNumber));
+			return false;
+		}
+
+		string includeFile = directory + line.substr(open + 1, close - open - 1);
+		if (find(includes.begin(), includes.end(), includeFile) == includes.end())
+			includes.push_back(includeFile);
+
+		output += "#line 1\n";
+		if (!Shader::PreprocessFile(includeFile, output, includes, depth + 1))
+			return false;
+		output += "#line " + to_string(lineNumber + 1) + "\n";
+	}
+	return true;
+}
+
+void Shader::InjectDefines(string &source) const
+{
+	if (defines.empty())
+		return;
+
+	// Defines go right after #version, which has to stay the first statement
+	size_t position = 0;
+	unsigned int lineNumber = 1;
+	size_t version = source.find("#version");
+	if (version != string::npos) {
+		size_t lineEnd = source.find('\n', version);
+		position = (lineEnd == string::npos) ? source.size() : lineEnd + 1;
+		lineNumber += static_cast<unsigned int>(count(source.begin(), source.begin() + position, '\n'));
+	}
+
+	string block;
+	for (auto &define : defines)
+		block += "#define " + define.first + " " + define.second + "\n";
+	block += "#line " + to_string(lineNumber) + "\n";
+	source.insert(position, block);
+}
+
+bool Shader::ReadShaderFile(const string &shaderFile, string &shader_code)
+{
 	ifstream file(shaderFile.c_str(), ios::in);
 
 	if(!file.good()) {
-		cout << "\tCould not open file: " << shaderFile << endl;
-		terminate();
+		Log::Error("\tCould not open file: " + shaderFile);
+		return false;
 	}
 
-	cout << "\tFILE = " << shaderFile;
-
 	// Get file content
 	file.seekg(0, ios::end);
 	shader_code.resize((unsigned int)file.tellg());
 	file.seekg(0, ios::beg);
 	file.read(&shader_code[0], shader_code.size());
 	file.close();
+	StartupReport::AddBytesRead(shader_code.size());
 
-	int infoLogLength = 0;
+	return true;
+}
+
+unsigned int Shader::CreateShader(const string &shaderFile, const string &shader_code, GLenum shaderType)
+{
 	int compileResult = 0;
 	unsigned int glShaderObject;
 
 	// Create new shader object
 	glShaderObject = glCreateShader(shaderType);
 	if (glShaderObject == 0) {
-		cout << "\t ..... ERROR " << endl;
+		Log::Error("\tFILE = " + shaderFile + "\t ..... ERROR");
 		return 0;
 	}
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_SHADER);
 
 	const char *shader_code_ptr = shader_code.c_str();
 	const int shader_code_size = (int) shader_code.size();
@@ -188,41 +525,48 @@ unsigned int Shader::CreateShader(const string &shaderFile, GLenum shaderType)
 	// LOG COMPILE ERRORS
 	if(compileResult == GL_FALSE)
 	{
-		string str_shader_type = "";
-
-		if(shaderType == GL_VERTEX_SHADER)				str_shader_type="VERTEX";
-		#ifndef OPENGL_ES
-		if(shaderType == GL_TESS_CONTROL_SHADER)		str_shader_type="TESS CONTROL";
-		if(shaderType == GL_TESS_EVALUATION_SHADER)		str_shader_type="TESS EVALUATION";
-		if(shaderType == GL_GEOMETRY_SHADER)			str_shader_type="GEOMETRY";
-		#endif
-		if(shaderType == GL_FRAGMENT_SHADER)			str_shader_type="FRAGMENT";
-		if(shaderType == GL_COMPUTE_SHADER)				str_shader_type="COMPUTE";
-
-		glGetShaderiv(glShaderObject, GL_INFO_LOG_LENGTH, &infoLogLength);
-		vector<char> shader_log(infoLogLength);
-		glGetShaderInfoLog(glShaderObject, infoLogLength, NULL, &shader_log[0]);
-
-		cout << "\n-----------------------------------------------------\n";
-		cout << "\n[ERROR]: [" << str_shader_type << " SHADER]\n\n";
-		cout << &shader_log[0] << "\n";
-		cout << "-----------------------------------------------------" << endl;
-
+		Log::Error("\tFILE = " + shaderFile);
+		LogCompileErrors(glShaderObject, shaderType);
 		return 0;
 	}
 
-	cout << "\t ..... COMPILED " << endl;
+	Log::Info("\tFILE = " + shaderFile + "\t ..... COMPILED");
 
 	return glShaderObject;
 }
 
-unsigned int Shader::CreateProgram(const vector<unsigned int> &shaderObjects)
+void Shader::LogCompileErrors(unsigned int glShaderObject, GLenum shaderType)
 {
 	int infoLogLength = 0;
+	string str_shader_type = "";
+
+	if(shaderType == GL_VERTEX_SHADER)				str_shader_type="VERTEX";
+	#ifndef OPENGL_ES
+	if(shaderType == GL_TESS_CONTROL_SHADER)		str_shader_type="TESS CONTROL";
+	if(shaderType == GL_TESS_EVALUATION_SHADER)		str_shader_type="TESS EVALUATION";
+	if(shaderType == GL_GEOMETRY_SHADER)			str_shader_type="GEOMETRY";
+	#endif
+	if(shaderType == GL_FRAGMENT_SHADER)			str_shader_type="FRAGMENT";
+	if(shaderType == GL_COMPUTE_SHADER)				str_shader_type="COMPUTE";
+
+	glGetShaderiv(glShaderObject, GL_INFO_LOG_LENGTH, &infoLogLength);
+	vector<char> shader_log(infoLogLength + 1);
+	glGetShaderInfoLog(glShaderObject, infoLogLength, NULL, &shader_log[0]);
+
+	LogErrorLines("[" + str_shader_type + " SHADER]", &shader_log[0]);
+}
+
+unsigned int Shader::CreateProgram(const vector<unsigned int> &shaderObjects)
+{
 	int linkResult = 0;
 
 	// build OpenGL program object and link all the OpenGL shader objects
 	unsigned int glProgramObject = glCreateProgram();
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_PROGRAM);
+
+	// Allows ShaderCache to read the linked binary back
+	if (ShaderCache::IsSupported())
+		glProgramParameteri(glProgramObject, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
 	for (auto shader: shaderObjects)
 		glAttachShader(glProgramObject, shader);
@@ -232,14 +576,7 @@ unsigned int Shader::CreateProgram(const vector<unsigned int> &shaderObjects)
 
 	// LOG LINK ERRORS
 	if(linkResult == GL_FALSE) {
-
-		glGetProgramiv(glProgramObject, GL_INFO_LOG_LENGTH, &infoLogLength);
-		vector<char> program_log(infoLogLength);
-		glGetProgramInfoLog(glProgramObject, infoLogLength, NULL, &program_log[0]);
-
-		cout << "Shader Loader : LINK ERROR" << endl;
-		cout << &program_log[0] << endl;
-
+		LogLinkErrors(glProgramObject);
 		return 0;
 	}
 
@@ -250,4 +587,14 @@ unsigned int Shader::CreateProgram(const vector<unsigned int> &shaderObjects)
 	return glProgramObject;
 
 	CheckOpenGLError();
+}
+
+void Shader::LogLinkErrors(unsigned int glProgramObject)
+{
+	int infoLogLength = 0;
+	glGetProgramiv(glProgramObject, GL_INFO_LOG_LENGTH, &infoLogLength);
+	vector<char> program_log(infoLogLength + 1);
+	glGetProgramInfoLog(glProgramObject, infoLogLength, NULL, &program_log[0]);
+
+	LogErrorLines("Shader Loader : LINK ERROR", &program_log[0]);
 }
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
 #include <functional>
+#include <cstdint>
 
 #include <include/gl.h>
 
@@ -21,8 +23,24 @@ class Shader
 		void Use() const;
 		unsigned int Reload();
 
+		// Non-blocking Reload: the new program is compiled and linked over the next frames and
+		// replaces the current one once it links. On errors the current program stays in use
+		void ReloadAsync();
+		// Advances a pending ReloadAsync, returns true while it is still in flight
+		bool UpdateReload();
+
 		void AddShader(const std::string &shaderFile, GLenum shaderType);
 		void ClearShaders();
+
+		// Injected after #version in every stage. Sources may also #include "file" relative to themselves
+		void AddDefine(const std::string &name, const std::string &value = "");
+
+		// Same stages and defines plus the given ones, built on first request and cached by define set
+		// Use it for cheaper permutations instead of branching on uniforms at runtime
+		Shader* GetVariant(std::vector<std::string> defines);
+
+		// Stage sources and every file they included in the last build
+		std::vector<std::string> GetShaderFiles() const;
 		unsigned int CreateAndLink();
 
 		void BindTexturesUnits();
@@ -30,10 +48,23 @@ class Shader
 
 		void OnLoad(std::function<void()> onLoad);
 
+		// Points the named uniform block at a buffer binding point. Kept with the shader and reapplied whenever a
+		// program is linked or reloaded, variants inherit it; programs without the block ignore it
+		void SetUniformBlockBinding(const std::string &blockName, GLuint binding);
+
 	private:
 		void GetUniforms();
-		static unsigned int CreateShader(const std::string &shaderFile, GLenum shaderType);
+		void BindUniformBlocks();
+		void CancelReload();
+		bool ReadSources(std::vector<std::string> &sources, uint64_t &programKey);
+		void InjectDefines(std::string &source) const;
+		std::string GetCacheName() const;
+		static bool PreprocessFile(const std::string &shaderFile, std::string &output, std::vector<std::string> &includes, unsigned int depth);
+		static bool ReadShaderFile(const std::string &shaderFile, std::string &shaderCode);
+		static unsigned int CreateShader(const std::string &shaderFile, const std::string &shaderCode, GLenum shaderType);
 		static unsigned int CreateProgram(const std::vector<unsigned int> &shaderObjects);
+		static void LogCompileErrors(unsigned int shaderObject, GLenum shaderType);
+		static void LogLinkErrors(unsigned int programObject);
 
 	public:
 		GLuint program;
@@ -76,5 +107,16 @@ class Shader
 
 		std::string shaderName;
 		std::vector<ShaderFile> shaderFiles;
+		std::vector<std::string> includedFiles;
+		std::vector<std::pair<std::string, std::string>> defines;
+		std::map<std::string, Shader*> variants;
+		std::vector<std::pair<std::string, GLuint>> blockBindings;
 		std::list<std::function<void()>> loadObservers;
+
+		// Background reload state, see ReloadAsync
+		enum class ReloadStage { NONE, COMPILING, LINKING };
+		ReloadStage reloadStage;
+		GLuint reloadProgram;
+		std::vector<GLuint> reloadShaders;
+		uint64_t reloadKey;
 };
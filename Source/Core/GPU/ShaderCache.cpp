@@ -0,0 +1,178 @@
+#include "ShaderCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <include/hash.h>
+#include <include/mapped_file.h>
+#include <include/temp_file.h>
+
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/StartupReport.h>
+
+using namespace std;
+
+unsigned int ShaderCache::cachedPrograms = 0;
+unsigned int ShaderCache::compiledPrograms = 0;
+unsigned int ShaderCache::staleBlobs = 0;
+double ShaderCache::cachedTime = 0;
+double ShaderCache::compiledTime = 0;
+unordered_map<string, string> ShaderCache::owners;
+
+namespace
+{
+	const char MAGIC[4] = { 'P', 'R', 'G', 'C' };
+
+	struct BlobHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t programKey;
+		uint64_t driverHash;
+		uint32_t binaryFormat;
+		uint32_t binarySize;
+	};
+
+	string GetString(GLenum name)
+	{
+		const GLubyte *value = glGetString(name);
+		return value ? reinterpret_cast<const char*>(value) : "";
+	}
+}
+
+bool ShaderCache::IsSupported()
+{
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+		return false;
+
+	GLint nrFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nrFormats);
+	return nrFormats > 0;
+}
+
+uint64_t ShaderCache::GetDriverHash()
+{
+	uint64_t hash = HashFNV1a(GetString(GL_VENDOR));
+	hash = HashFNV1a(GetString(GL_RENDERER), hash);
+	return HashFNV1a(GetString(GL_VERSION), hash);
+}
+
+string ShaderCache::GetCacheFile(const string &file)
+{
+	return file + ".progcache";
+}
+
+bool ShaderCache::Claim(const string &file, const string &owner)
+{
+	auto it = owners.emplace(file, owner).first;
+	if (it->second == owner)
+		return true;
+
+	Log::Error("[ShaderCache] " + owner + " and " + it->second + " map to the same blob, " + owner +
+		" is not cached", { { "file", GetCacheFile(file) } });
+	return false;
+}
+
+GLuint ShaderCache::Read(const string &file, uint64_t programKey)
+{
+	if (!IsSupported())
+		return 0;
+
+	MappedFile blob;
+	if (!blob.Open(GetCacheFile(file).c_str()) || blob.GetSize() < sizeof(BlobHeader))
+		return 0;
+	StartupReport::AddBytesRead(blob.GetSize());
+
+	const BlobHeader *header = reinterpret_cast<const BlobHeader*>(blob.GetData());
+	if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) || header->version != VERSION)
+		return 0;
+
+	if (header->programKey != programKey) {
+		staleBlobs++;
+		return 0;
+	}
+
+	if (header->driverHash != GetDriverHash())
+		return 0;
+
+	if (blob.GetSize() != sizeof(BlobHeader) + header->binarySize)
+		return 0;
+
+	GLuint program = glCreateProgram();
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_PROGRAM);
+	glProgramBinary(program, header->binaryFormat, blob.GetData() + sizeof(BlobHeader), header->binarySize);
+
+	// Drivers may reject a binary they produced themselves (e.g. after an update that kept the version string)
+	GLint linkResult = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linkResult);
+	if (linkResult == GL_FALSE) {
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+}
+
+bool ShaderCache::Write(const string &file, uint64_t programKey, GLuint program)
+{
+	if (!IsSupported())
+		return false;
+
+	GLint binarySize = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+	if (binarySize <= 0)
+		return false;
+
+	vector<char> binary(binarySize);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(program, binarySize, &binarySize, &binaryFormat, binary.data());
+
+	BlobHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.programKey = programKey;
+	header.driverHash = GetDriverHash();
+	header.binaryFormat = binaryFormat;
+	header.binarySize = static_cast<uint32_t>(binarySize);
+
+	// Write to a temporary file first so a partially written blob is never picked up
+	string cacheFile = GetCacheFile(file);
+	string tempFile = MakeTempFileName(cacheFile);
+	{
+		ofstream out(tempFile.c_str(), ios::out | ios::binary | ios::trunc);
+		if (!out.good())
+			return false;
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(binary.data(), binarySize);
+
+		if (!out.good()) {
+			out.close();
+			remove(tempFile.c_str());
+			return false;
+		}
+	}
+
+	return CommitTempFile(tempFile, cacheFile);
+}
+
+void ShaderCache::AddBuildTime(bool cached, double milliseconds)
+{
+	if (cached) {
+		cachedPrograms++;
+		cachedTime += milliseconds;
+	}
+	else {
+		compiledPrograms++;
+		compiledTime += milliseconds;
+	}
+}
+
+void ShaderCache::PrintStats()
+{
+	Log::Info("SHADERS", { { "cached", cachedPrograms }, { "cached_ms", cachedTime },
+		{ "compiled", compiledPrograms }, { "compiled_ms", compiledTime }, { "stale", staleBlobs } });
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+#include <include/gl.h>
+
+/*
+ *	Linked program binaries (glProgramBinary) stored next to the first shader source as "<file>.<hash>.progcache",
+ *	the hash covering every stage file and define
+ *	The blob is only used when the program key (hash of every stage source) and the driver still match,
+ *	a binary the driver rejects is dropped and the program is compiled from source again
+ */
+
+class ShaderCache
+{
+	public:
+		// Bump whenever the blob layout changes
+		static const unsigned int VERSION = 1;
+
+		// Needs GL 4.1 or ARB_get_program_binary and at least one binary format
+		static bool IsSupported();
+
+		// Returns a linked program or 0 on miss, stale blob or rejected binary
+		static GLuint Read(const std::string &file, uint64_t programKey);
+
+		// Only programs linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT can be written
+		static bool Write(const std::string &file, uint64_t programKey, GLuint program);
+
+		static std::string GetCacheFile(const std::string &file);
+
+		// Each blob belongs to one program: a second program claiming it would overwrite it on every run, so it is
+		// refused and that program is built without the cache
+		static bool Claim(const std::string &file, const std::string &owner);
+
+		// Startup report: programs loaded from cache vs compiled from source and the time spent on each, and blobs
+		// found with another program key (sources edited since, or two programs sharing a blob)
+		static void AddBuildTime(bool cached, double milliseconds);
+		static void PrintStats();
+
+	protected:
+		ShaderCache() = delete;
+		~ShaderCache() = delete;
+
+	private:
+		// Hash of GL_VENDOR, GL_RENDERER and GL_VERSION, binaries never survive a driver change
+		static uint64_t GetDriverHash();
+
+	private:
+		static unsigned int cachedPrograms;
+		static unsigned int compiledPrograms;
+		static unsigned int staleBlobs;
+		static double cachedTime;
+		static double compiledTime;
+		static std::unordered_map<std::string, std::string> owners;
+};
@@ -0,0 +1,104 @@
+#include "StaticBatch.h"
+
+#include <include/utils.h>
+
+#include <Core/GPU/GPUBuffers.h>
+#include <Core/GPU/Mesh.h>
+#include <Core/Profiling/GpuProfiler.h>
+
+using namespace std;
+
+StaticBatch::StaticBatch()
+{
+	buffers = nullptr;
+	drawMode = GL_TRIANGLES;
+}
+
+StaticBatch::~StaticBatch()
+{
+	if (buffers)
+		buffers->ReleaseMemory();
+	SAFE_FREE(buffers);
+}
+
+void StaticBatch::Add(Mesh *mesh, unsigned int materialIndex)
+{
+	Source source;
+	source.mesh = mesh;
+	source.materialIndex = materialIndex;
+	sources.push_back(source);
+}
+
+bool StaticBatch::IsBuilt() const
+{
+	return buffers != nullptr;
+}
+
+bool StaticBatch::Build()
+{
+	if (IsBuilt())
+		return true;
+
+	for (auto &source : sources) {
+		if (!source.mesh->IsLoaded())
+			return false;
+	}
+
+	vector<glm::vec3> positions;
+	vector<glm::vec3> normals;
+	vector<glm::vec2> texCoords;
+	vector<float> materialIndices;
+	vector<unsigned short> indices;
+	// Kept aside until the batch is known to be valid, a failed Build leaves the draw ranges untouched
+	vector<GLsizei> batchCounts;
+	vector<const void*> batchOffsets;
+	vector<GLint> batchBaseVertices;
+	GLenum batchDrawMode = drawMode;
+
+	// Indices stay local to their submesh, the base vertex of each draw moves them into the merged buffer
+	for (auto &source : sources)
+	{
+		const Mesh *mesh = source.mesh;
+		GLint vertexOffset = static_cast<GLint>(positions.size());
+		size_t indexOffset = indices.size();
+
+		positions.insert(positions.end(), mesh->positions.begin(), mesh->positions.end());
+		normals.insert(normals.end(), mesh->normals.begin(), mesh->normals.end());
+		texCoords.insert(texCoords.end(), mesh->texCoords.begin(), mesh->texCoords.end());
+		texCoords.resize(positions.size());
+		materialIndices.resize(positions.size(), static_cast<float>(source.materialIndex));
+		indices.insert(indices.end(), mesh->indices.begin(), mesh->indices.end());
+
+		for (auto &entry : mesh->meshEntries) {
+			batchCounts.push_back(entry.nrIndices);
+			batchOffsets.push_back((void*)(sizeof(unsigned short) * (indexOffset + entry.baseIndex)));
+			batchBaseVertices.push_back(vertexOffset + entry.baseVertex);
+		}
+		batchDrawMode = mesh->GetDrawMode();
+	}
+
+	if (positions.empty() || normals.size() != positions.size())
+		return false;
+
+	counts.swap(batchCounts);
+	offsets.swap(batchOffsets);
+	baseVertices.swap(batchBaseVertices);
+	drawMode = batchDrawMode;
+
+	buffers = new GPUBuffers();
+	*buffers = UtilsGPU::UploadData(positions, normals, texCoords, materialIndices, indices);
+	return true;
+}
+
+void StaticBatch::Render() const
+{
+	if (!IsBuilt())
+		return;
+
+	glBindVertexArray(buffers->VAO);
+	GpuProfiler::CountStateChange();
+	GpuProfiler::CountMultiDraw(drawMode, counts.data(), static_cast<unsigned int>(counts.size()));
+	glMultiDrawElementsBaseVertex(drawMode, counts.data(), GL_UNSIGNED_SHORT, offsets.data(),
+		static_cast<GLsizei>(counts.size()), baseVertices.data());
+	glBindVertexArray(0);
+}
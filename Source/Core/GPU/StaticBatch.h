@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+
+#include <include/gl.h>
+
+class Mesh;
+class GPUBuffers;
+
+/*
+ *	Merges meshes that share a model matrix into one vertex/index buffer drawn with a single glMultiDrawElementsBaseVertex
+ *	Every vertex carries the material index of its source mesh (attribute 3) so one draw can shade several materials
+ */
+
+class StaticBatch
+{
+	public:
+		StaticBatch();
+		~StaticBatch();
+
+		StaticBatch(const StaticBatch&) = delete;
+		StaticBatch& operator=(const StaticBatch&) = delete;
+
+		void Add(Mesh *mesh, unsigned int materialIndex);
+
+		// Merges the sources once all of them are loaded, returns false while some are still in flight
+		bool Build();
+		bool IsBuilt() const;
+
+		void Render() const;
+
+	private:
+		struct Source
+		{
+			Mesh *mesh;
+			unsigned int materialIndex;
+		};
+
+		std::vector<Source> sources;
+		GPUBuffers *buffers;
+		GLenum drawMode;
+
+		// One entry per submesh of every source
+		std::vector<GLsizei> counts;
+		std::vector<const void*> offsets;
+		std::vector<GLint> baseVertices;
+};
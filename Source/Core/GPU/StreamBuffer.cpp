@@ -0,0 +1,185 @@
+#include "StreamBuffer.h"
+
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/StartupReport.h>
+
+// Nanoseconds BeginFrame waits on a fence before trying again
+#define FENCE_TIMEOUT	1000000
+
+StreamBuffer::StreamBuffer()
+{
+	bufferID = 0;
+	target = GL_ARRAY_BUFFER;
+	size = 0;
+	regionSize = 0;
+	region = 0;
+	head = 0;
+	regionEnd = 0;
+	flushed = 0;
+	mapped = nullptr;
+	for (auto &fence : fences)
+		fence = nullptr;
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	Release();
+}
+
+bool StreamBuffer::Init(GLenum target, size_t size)
+{
+	Release();
+
+	if (!size) {
+		Log::Error("[StreamBuffer] Empty buffer requested");
+		return false;
+	}
+
+	this->target = target;
+	glGenBuffers(1, &bufferID);
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_BUFFER);
+	glBindBuffer(target, bufferID);
+
+	if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+	{
+		// Regions start on a 256 byte boundary, enough for any uniform/vertex alignment
+		regionSize = (size / FRAME_REGIONS) & ~size_t(255);
+		if (!regionSize) {
+			Log::Error("[StreamBuffer] Size too small for the frame regions", { { "size", static_cast<unsigned long long>(size) },
+				{ "minimum", FRAME_REGIONS * 256 } });
+			Release();
+			return false;
+		}
+		this->size = regionSize * FRAME_REGIONS;
+
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, this->size, nullptr, flags);
+		mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, this->size, flags));
+	}
+
+	if (!mapped)
+	{
+		// Immutable storage cannot be reallocated, start over with a fresh buffer
+		if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+			glDeleteBuffers(1, &bufferID);
+			glGenBuffers(1, &bufferID);
+			glBindBuffer(target, bufferID);
+		}
+
+		// Orphaning fallback: the whole buffer is one region, replaced by fresh storage every frame
+		regionSize = size;
+		this->size = size;
+		glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+		staging.resize(size);
+	}
+
+	glBindBuffer(target, 0);
+	region = 0;
+	head = 0;
+	flushed = 0;
+	regionEnd = regionSize;
+
+	CheckOpenGLError();
+	return bufferID != 0;
+}
+
+void StreamBuffer::Release()
+{
+	for (auto &fence : fences) {
+		if (fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	if (bufferID) {
+		if (mapped) {
+			glBindBuffer(target, bufferID);
+			glUnmapBuffer(target);
+			glBindBuffer(target, 0);
+		}
+		glDeleteBuffers(1, &bufferID);
+	}
+
+	bufferID = 0;
+	mapped = nullptr;
+	staging.clear();
+	staging.shrink_to_fit();
+}
+
+void StreamBuffer::BeginFrame()
+{
+	if (!bufferID)
+		return;
+
+	if (!mapped)
+	{
+		glBindBuffer(target, bufferID);
+		glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(target, 0);
+		head = flushed = 0;
+		regionEnd = size;
+		return;
+	}
+
+	region = (region + 1) % FRAME_REGIONS;
+	if (fences[region])
+	{
+		// Only blocks when the CPU is FRAME_REGIONS frames ahead of the GPU
+		GLenum status = glClientWaitSync(fences[region], 0, 0);
+		while (status == GL_TIMEOUT_EXPIRED)
+			status = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+
+		glDeleteSync(fences[region]);
+		fences[region] = nullptr;
+	}
+
+	head = flushed = region * regionSize;
+	regionEnd = head + regionSize;
+}
+
+void StreamBuffer::EndFrame()
+{
+	if (!mapped)
+		return;
+
+	if (fences[region])
+		glDeleteSync(fences[region]);
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* StreamBuffer::Allocate(size_t size, size_t alignment, size_t &offset)
+{
+	size_t start = alignment > 1 ? (head + alignment - 1) / alignment * alignment : head;
+	if (start + size > regionEnd)
+		return nullptr;
+
+	offset = start;
+	head = start + size;
+	return mapped ? mapped + start : staging.data() + start;
+}
+
+void StreamBuffer::Flush()
+{
+	if (mapped || head == flushed)
+		return;
+
+	glBindBuffer(target, bufferID);
+	glBufferSubData(target, flushed, head - flushed, staging.data() + flushed);
+	glBindBuffer(target, 0);
+	flushed = head;
+}
+
+GLuint StreamBuffer::GetBufferID() const
+{
+	return bufferID;
+}
+
+GLenum StreamBuffer::GetTarget() const
+{
+	return target;
+}
+
+bool StreamBuffer::IsPersistent() const
+{
+	return mapped != nullptr;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+
+#include <include/gl.h>
+
+/*
+ *	Ring buffer for data rewritten every frame (instance matrices, lines, particles)
+ *	With GL 4.4 / ARB_buffer_storage the buffer is persistently mapped and split into one region per frame in flight,
+ *	a fence per region tells when the GPU is done with it. Otherwise the buffer is orphaned every frame and the
+ *	writes are staged on the CPU and uploaded with glBufferSubData on Flush
+ */
+
+class StreamBuffer
+{
+	public:
+		// Frames the CPU may run ahead of the GPU before BeginFrame waits
+		static const unsigned int FRAME_REGIONS = 3;
+
+		StreamBuffer();
+		~StreamBuffer();
+
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+		// size is the total capacity, each frame can use size / FRAME_REGIONS bytes rounded down to 256
+		// Fails when that leaves a region empty (size below FRAME_REGIONS * 256 on the persistent path)
+		bool Init(GLenum target, size_t size);
+		void Release();
+
+		// Waits (only if needed) until the GPU released the region reused by this frame
+		void BeginFrame();
+		// Fences the commands that read this frame's region
+		void EndFrame();
+
+		// Reserves size bytes in the current frame region and returns where to write them
+		// offset receives the byte offset to use in glVertexAttribPointer / glBindBufferRange
+		// Returns nullptr when the frame region is full
+		void* Allocate(size_t size, size_t alignment, size_t &offset);
+
+		// Makes the bytes written since the last Flush visible to the GPU, call it before drawing
+		// Nothing to do on the persistent (coherent) path
+		void Flush();
+
+		GLuint GetBufferID() const;
+		GLenum GetTarget() const;
+		bool IsPersistent() const;
+
+	private:
+		GLuint bufferID;
+		GLenum target;
+		size_t size;
+		size_t regionSize;
+
+		unsigned int region;
+		size_t head;
+		size_t regionEnd;
+		size_t flushed;
+
+		unsigned char *mapped;
+		std::vector<unsigned char> staging;
+		GLsync fences[FRAME_REGIONS];
+};
@@ -1,9 +1,12 @@
 #include "Texture2D.h"
 
 #include <thread>
-#include <iostream>
 
 #include <include/gl.h>
+#include <include/math.h>
+
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/StartupReport.h>
 
 using namespace std;
 
@@ -40,9 +43,46 @@ Texture2D::Texture2D()
 	wrappingMode = GL_REPEAT;
 	textureMinFilter = GL_LINEAR;
 	textureMagFilter = GL_LINEAR;
+	residentBytes = 0;
+}
+
+Texture2D::~Texture2D()
+{
+	Release();
+}
+
+void Texture2D::Release()
+{
+	if (textureID)
+		glDeleteTextures(1, &textureID);
+	textureID = 0;
+	residentBytes = 0;
 }
 
-Texture2D::~Texture2D() {
+size_t Texture2D::GetResidentBytes() const
+{
+	return residentBytes;
+}
+
+void Texture2D::ComputeResidentBytes(GLenum format, bool compressed, bool mipmaps)
+{
+	// BC1 and RGTC1 store a 4x4 block in 8 bytes, BC3 and RGTC2 in 16
+	unsigned int blockBytes = (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RED_RGTC1) ? 8 : 16;
+	unsigned int texelBytes = (format == static_cast<GLenum>(internalFormat[1][channels])) ? 2 * channels : channels;
+
+	residentBytes = 0;
+	unsigned int levelWidth = width, levelHeight = height;
+	while (true)
+	{
+		residentBytes += compressed
+			? size_t((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockBytes
+			: size_t(levelWidth) * levelHeight * texelBytes;
+
+		if (!mipmaps || (levelWidth == 1 && levelHeight == 1))
+			break;
+		levelWidth = MAX(levelWidth / 2, 1u);
+		levelHeight = MAX(levelHeight / 2, 1u);
+	}
 }
 
 GLuint Texture2D::GetTextureID() const
@@ -56,33 +96,27 @@ void Texture2D::Init(GLuint gpuTextureID, unsigned int width, unsigned int heigh
 	this->width = width;
 	this->height = height;
 	this->channels = channels;
+	ComputeResidentBytes(internalFormat[0][channels], false, false);
 }
 
 bool Texture2D::Load2D(const char* fileName, GLenum wrapping_mode)
 {
 	int width, height, chn;
+	StartupReport::AddFileRead(fileName);
 	unsigned char *data = stbi_load(fileName, &width, &height, &chn, 0);
 
 	if (data == NULL) {
 		#ifdef DEBUG_INFO
-		cout << "ERROR loading texture: " << file_name << endl << endl;
+		Log::Error(string("ERROR loading texture: ") + fileName);
 		#endif
 		return false;
 	}
 
 	#ifdef DEBUG_INFO
-	cout << "Loaded " << file_name << endl;
-	cout << width << " * " << height << " channels: " << chn << endl << endl;
+	Log::Debug(string("Loaded ") + fileName, { { "width", width }, { "height", height }, { "channels", chn } });
 	#endif
 
-	textureMinFilter = GL_LINEAR_MIPMAP_LINEAR;
-	wrappingMode = wrapping_mode;
-
-	Init2DTexture(width, height, chn);
-	glTexImage2D(targetType, 0, internalFormat[0][chn], width, height, 0, pixelFormat[chn], GL_UNSIGNED_BYTE, data);
-	glGenerateMipmap(targetType);
-	glBindTexture(targetType, 0);
-	CheckOpenGLError();
+	CreateWithMipmaps(data, width, height, chn, wrapping_mode);
 
 	stbi_image_free(data);
 	return true;
@@ -117,6 +151,67 @@ void Texture2D::Create(const unsigned char* img, int width, int height, int chn)
 	Init2DTexture(width, height, chn);
 	glTexImage2D(targetType, 0, internalFormat[0][chn], width, height, 0, pixelFormat[chn], GL_UNSIGNED_BYTE, (void*)img);
 	UnBind();
+
+	ComputeResidentBytes(internalFormat[0][chn], false, false);
+}
+
+void Texture2D::CreateWithMipmaps(const unsigned char* img, int width, int height, int chn, GLenum wrapping_mode, bool compress)
+{
+	textureMinFilter = GL_LINEAR_MIPMAP_LINEAR;
+	wrappingMode = wrapping_mode;
+
+	// When compressing, the driver encodes level 0 and every generated mip level
+	GLenum format = compress ? GetCompressedFormat(chn) : 0;
+	if (format == 0)
+		format = internalFormat[0][chn];
+
+	Init2DTexture(width, height, chn);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(targetType, 0, format, width, height, 0, pixelFormat[chn], GL_UNSIGNED_BYTE, img);
+	glGenerateMipmap(targetType);
+	glBindTexture(targetType, 0);
+	CheckOpenGLError();
+
+	ComputeResidentBytes(format, format != static_cast<GLenum>(internalFormat[0][chn]), true);
+}
+
+void Texture2D::CreateFromLevels(const vector<TextureLevel> &levels, unsigned int chn, GLenum format, bool compressed, GLenum wrapping_mode)
+{
+	if (levels.empty())
+		return;
+
+	textureMinFilter = levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+	wrappingMode = wrapping_mode;
+
+	Init2DTexture(levels[0].width, levels[0].height, chn);
+	glTexParameteri(targetType, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size()) - 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (unsigned int i = 0; i < levels.size(); i++)
+	{
+		auto &level = levels[i];
+		if (compressed)
+			glCompressedTexImage2D(targetType, i, format, level.width, level.height, 0, level.size, level.data);
+		else
+			glTexImage2D(targetType, i, format, level.width, level.height, 0, pixelFormat[chn], GL_UNSIGNED_BYTE, level.data);
+		residentBytes += level.size;
+	}
+
+	glBindTexture(targetType, 0);
+	CheckOpenGLError();
+}
+
+GLenum Texture2D::GetCompressedFormat(unsigned int channels)
+{
+	// RGTC is core since OpenGL 3.0, S3TC (BC1/BC3) is an extension on some drivers
+	switch (channels)
+	{
+		case 1: return GL_COMPRESSED_RED_RGTC1;
+		case 2: return GL_COMPRESSED_RG_RGTC2;
+		case 3: return GLEW_EXT_texture_compression_s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+		case 4: return GLEW_EXT_texture_compression_s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+		default: return 0;
+	}
 }
 
 void Texture2D::CreateU16(const unsigned short* img, int width, int height, int chn)
@@ -124,6 +219,8 @@ void Texture2D::CreateU16(const unsigned short* img, int width, int height, int
 	Init2DTexture(width, height, chn);
 	glTexImage2D(targetType, 0, internalFormat[1][chn], width, height, 0, pixelFormat[chn], GL_UNSIGNED_SHORT, (void*)img);
 	UnBind();
+
+	ComputeResidentBytes(internalFormat[1][chn], false, false);
 }
 
 void Texture2D::Bind() const
@@ -163,6 +260,11 @@ unsigned int Texture2D::GetHeight() const
 	return height;
 }
 
+unsigned int Texture2D::GetChannels() const
+{
+	return channels;
+}
+
 void Texture2D::GetSize(unsigned int &width,unsigned int &height) const
 {
 	width = this->width;
@@ -212,9 +314,9 @@ void Texture2D::Init2DTexture(unsigned int width, unsigned int height, unsigned
 	this->height = height;
 	this->channels = channels;
 
-	if (textureID)
-		glDeleteTextures(1, &textureID);
+	Release();
 	glGenTextures(1, &textureID);
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_TEXTURE);
 	glBindTexture(targetType, textureID);
 	SetTextureParameters();
 	glPixelStorei(GL_PACK_ALIGNMENT, 1);
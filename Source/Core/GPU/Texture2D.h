@@ -1,7 +1,18 @@
 #pragma once
+#include <vector>
+
 #include <include/gl.h>
 #include <include/utils.h>
 
+// One level of a prebuilt mip chain
+struct TextureLevel
+{
+	unsigned int width;
+	unsigned int height;
+	unsigned int size;
+	const unsigned char *data;
+};
+
 class Texture2D
 {
 	public:
@@ -18,12 +29,17 @@ class Texture2D
 		void Init(GLuint gpuTextureID, unsigned int width, unsigned int height, unsigned int channels);
 		void Create(const unsigned char* img, int width, int height, int chn);
 		void CreateU16(const unsigned short* img, int width, int height, int chn);
+		void CreateWithMipmaps(const unsigned char* img, int width, int height, int chn, GLenum wrappingMode = GL_REPEAT, bool compress = false);
+
+		// Uploads a prebuilt mip chain level by level, level 0 first
+		void CreateFromLevels(const std::vector<TextureLevel> &levels, unsigned int chn, GLenum format, bool compressed, GLenum wrappingMode = GL_REPEAT);
 
 		bool Load2D(const char* fileName, GLenum wrappingMode = GL_REPEAT);
 		void SaveToFile(const char* fileName) const;
 
 		unsigned int GetWidth() const;
 		unsigned int GetHeight() const;
+		unsigned int GetChannels() const;
 		void GetSize(unsigned int &width, unsigned int &height) const;
 
 		void SetWrappingMode(GLenum mode);
@@ -31,9 +47,19 @@ class Texture2D
 
 		GLuint GetTextureID() const;
 
+		// Deletes the GPU texture, the object stays valid and can be created again
+		void Release();
+
+		// Approximate video memory used by all mip levels, 0 when not resident
+		size_t GetResidentBytes() const;
+
+		// Block compressed format the driver can encode for the given channel count, 0 if none
+		static GLenum GetCompressedFormat(unsigned int channels);
+
 	private:
 		void SetTextureParameters();
 		void Init2DTexture(unsigned int width, unsigned int height, unsigned int channels);
+		void ComputeResidentBytes(GLenum format, bool compressed, bool mipmaps);
 
 	private:
 		unsigned int width;
@@ -44,4 +70,5 @@ class Texture2D
 		GLenum wrappingMode;
 		GLenum textureMinFilter;
 		GLenum textureMagFilter;
+		size_t residentBytes;
 };
@@ -0,0 +1,191 @@
+#include "TextureCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include <include/hash.h>
+#include <include/temp_file.h>
+
+#include <Core/Managers/AssetLoader.h>
+#include <Core/Profiling/StartupReport.h>
+#include <Core/Threading/ThreadPool.h>
+
+using namespace std;
+
+namespace
+{
+	const char MAGIC[4] = { 'T', 'X', 'C', 'H' };
+	const GLenum pixelFormat[5] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+
+	struct ContainerHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t compressRequested;
+		uint32_t compressed;
+		uint32_t format;
+		uint32_t channels;
+		uint32_t nrLevels;
+		uint32_t reserved;
+	};
+
+	struct LevelRecord
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t offset;
+		uint32_t size;
+	};
+}
+
+string TextureCache::GetCacheFile(const string &file)
+{
+	return file + ".texcache";
+}
+
+bool TextureCache::Read(const string &file, bool compress, TextureLevels &texture)
+{
+	MappedFile blob;
+	if (!blob.Open(GetCacheFile(file).c_str()) || blob.GetSize() < sizeof(ContainerHeader))
+		return false;
+	StartupReport::AddBytesRead(blob.GetSize());
+
+	const ContainerHeader *header = reinterpret_cast<const ContainerHeader*>(blob.GetData());
+	if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) || header->version != VERSION)
+		return false;
+
+	if (header->compressRequested != (compress ? 1u : 0u) || header->nrLevels == 0 || header->channels > 4)
+		return false;
+
+	// Blocks baked on another machine are useless if this driver can't sample them
+	if (header->compressed && Texture2D::GetCompressedFormat(header->channels) != header->format)
+		return false;
+
+	size_t tableEnd = sizeof(ContainerHeader) + header->nrLevels * sizeof(LevelRecord);
+	if (blob.GetSize() < tableEnd)
+		return false;
+
+	uint64_t sourceHash;
+	size_t sourceSize = 0;
+	bool hashed = HashFile(file, sourceHash, FNV1A_64_SEED, &sourceSize);
+	StartupReport::AddBytesRead(sourceSize);
+	if (!hashed || sourceHash != header->sourceHash)
+		return false;
+
+	const LevelRecord *records = reinterpret_cast<const LevelRecord*>(blob.GetData() + sizeof(ContainerHeader));
+	texture.levels.resize(header->nrLevels);
+	for (unsigned int i = 0; i < header->nrLevels; i++)
+	{
+		if (records[i].offset < tableEnd || size_t(records[i].offset) + records[i].size > blob.GetSize())
+			return false;
+
+		texture.levels[i].width = records[i].width;
+		texture.levels[i].height = records[i].height;
+		texture.levels[i].size = records[i].size;
+		texture.levels[i].data = blob.GetData() + records[i].offset;
+	}
+
+	texture.channels = header->channels;
+	texture.format = header->format;
+	texture.compressed = header->compressed != 0;
+	texture.blob = move(blob);
+	return true;
+}
+
+void TextureCache::Write(const string &file, bool compress, const Texture2D *texture)
+{
+	auto header = make_shared<ContainerHeader>();
+	auto records = make_shared<vector<LevelRecord>>();
+	auto data = make_shared<vector<unsigned char>>();
+
+	memset(header.get(), 0, sizeof(ContainerHeader));
+	memcpy(header->magic, MAGIC, sizeof(MAGIC));
+	header->version = VERSION;
+	header->compressRequested = compress ? 1 : 0;
+
+	GLint compressed = 0, format = 0;
+	glBindTexture(GL_TEXTURE_2D, texture->GetTextureID());
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+
+	unsigned int channels = texture->GetChannels();
+
+	header->compressed = compressed ? 1 : 0;
+	header->format = format;
+	header->channels = channels;
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	unsigned int width = texture->GetWidth();
+	unsigned int height = texture->GetHeight();
+	for (GLint level = 0; ; level++)
+	{
+		LevelRecord record;
+		record.width = width;
+		record.height = height;
+		record.offset = static_cast<uint32_t>(data->size());
+
+		if (compressed) {
+			GLint size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+			record.size = size;
+			data->resize(data->size() + size);
+			glGetCompressedTexImage(GL_TEXTURE_2D, level, data->data() + record.offset);
+		}
+		else {
+			record.size = width * height * channels;
+			data->resize(data->size() + record.size);
+			glGetTexImage(GL_TEXTURE_2D, level, pixelFormat[channels], GL_UNSIGNED_BYTE, data->data() + record.offset);
+		}
+		records->push_back(record);
+
+		if (width == 1 && height == 1)
+			break;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	CheckOpenGLError();
+
+	header->nrLevels = static_cast<uint32_t>(records->size());
+
+	// Hashing the source and writing the container stay off the render thread
+	auto writeContainer = [file, header, records, data]()
+	{
+		size_t sourceSize = 0;
+		bool hashed = HashFile(file, header->sourceHash, FNV1A_64_SEED, &sourceSize);
+		StartupReport::AddBytesRead(sourceSize);
+		if (!hashed)
+			return;
+
+		uint32_t dataStart = static_cast<uint32_t>(sizeof(ContainerHeader) + records->size() * sizeof(LevelRecord));
+		for (auto &record : *records) {
+			record.offset += dataStart;
+		}
+
+		string cacheFile = GetCacheFile(file);
+		string tempFile = MakeTempFileName(cacheFile);
+		{
+			ofstream out(tempFile.c_str(), ios::out | ios::binary | ios::trunc);
+			if (!out.good())
+				return;
+
+			out.write(reinterpret_cast<const char*>(header.get()), sizeof(ContainerHeader));
+			out.write(reinterpret_cast<const char*>(records->data()), records->size() * sizeof(LevelRecord));
+			out.write(reinterpret_cast<const char*>(data->data()), data->size());
+
+			if (!out.good()) {
+				out.close();
+				remove(tempFile.c_str());
+				return;
+			}
+		}
+
+		CommitTempFile(tempFile, cacheFile);
+	};
+
+	ThreadPool *threadPool = AssetLoader::GetThreadPool();
+	threadPool ? threadPool->Enqueue(writeContainer) : writeContainer();
+}
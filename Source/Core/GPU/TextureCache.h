@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <include/gl.h>
+#include <include/mapped_file.h>
+
+#include <Core/GPU/Texture2D.h>
+
+/*
+ *	GPU-ready copy of a texture, stored next to the source image as "<file>.texcache"
+ *	The container holds the full mip chain, block compressed (BC1/BC3/RGTC) when the driver
+ *	supports it, so later runs skip image decoding and mipmap generation. The blob is keyed
+ *	by the source file hash and by whether compression was requested
+ */
+
+// Baked texture mapped from disk, the levels point into the mapping
+struct TextureLevels
+{
+	MappedFile blob;
+	unsigned int channels;
+	GLenum format;
+	bool compressed;
+	std::vector<TextureLevel> levels;
+};
+
+class TextureCache
+{
+	public:
+		// Bump whenever the container layout changes
+		static const unsigned int VERSION = 1;
+
+		// Maps a baked texture, does not touch the OpenGL context. Returns false on miss or stale blob
+		static bool Read(const std::string &file, bool compress, TextureLevels &texture);
+
+		// Reads back the mip chain of a freshly uploaded texture on the render thread,
+		// the container is written on the loader threads
+		static void Write(const std::string &file, bool compress, const Texture2D *texture);
+
+		static std::string GetCacheFile(const std::string &file);
+
+	protected:
+		TextureCache() = delete;
+		~TextureCache() = delete;
+};
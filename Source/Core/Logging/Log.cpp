@@ -0,0 +1,383 @@
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+#include <sstream>
+
+#include <Core/Profiling/Profiler.h>
+
+using namespace std;
+
+atomic<int> Log::minLevel(static_cast<int>(LogLevel::INFO));
+atomic<bool> Log::running(false);
+thread Log::writer;
+string Log::fileName;
+FILE* Log::file = nullptr;
+mutex Log::ringsMutex;
+vector<Log::ThreadRing*> Log::rings;
+atomic<uint64_t> Log::sequence(0);
+atomic<uint64_t> Log::dropped(0);
+atomic<bool> Log::sleeping(false);
+mutex Log::wakeMutex;
+condition_variable Log::wake;
+condition_variable Log::drained;
+uint64_t Log::passes = 0;
+
+namespace
+{
+	// Upper bound on how late a line can be written when its wake-up is missed
+	const chrono::milliseconds WRITER_TIMEOUT(50);
+
+	const char* LevelName(LogLevel level)
+	{
+		switch (level)
+		{
+			case LogLevel::DEBUG:
+				return "DEBUG";
+			case LogLevel::INFO:
+				return "INFO";
+			case LogLevel::WARN:
+				return "WARN";
+			default:
+				return "ERROR";
+		}
+	}
+
+	// Appends to a fixed buffer, cutting whatever does not fit
+	class LineWriter
+	{
+		public:
+			LineWriter(char *buffer, size_t size) : buffer(buffer), size(size), length(0)
+			{
+				buffer[0] = 0;
+			}
+
+			void Append(const char *text)
+			{
+				size_t count = min(strlen(text), size - 1 - length);
+				memcpy(buffer + length, text, count);
+				length += count;
+				buffer[length] = 0;
+			}
+
+			template <typename T>
+			void AppendFormat(const char *format, T value)
+			{
+				char text[64];
+				snprintf(text, sizeof(text), format, value);
+				Append(text);
+			}
+
+		private:
+			char *buffer;
+			size_t size;
+			size_t length;
+	};
+}
+
+void Log::Init()
+{
+	if (running)
+		return;
+
+	if (!fileName.empty()) {
+		file = fopen(fileName.c_str(), "w");
+		if (!file)
+			Warn("Could not write the log file", { { "file", fileName } });
+	}
+
+	running = true;
+	writer = thread(WriterLoop);
+}
+
+void Log::Exit()
+{
+	if (!running)
+		return;
+
+	{
+		lock_guard<mutex> lock(wakeMutex);
+		running = false;
+	}
+	wake.notify_one();
+	writer.join();
+
+	// Lines logged while the writer stopped
+	vector<Line> batch;
+	Drain(batch);
+
+	if (dropped)
+		Warn("Log rings were full, lines were dropped", { { "dropped", static_cast<unsigned long long>(dropped) } });
+
+	if (file) {
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+void Log::SetLevel(LogLevel level)
+{
+	minLevel.store(static_cast<int>(level), memory_order_relaxed);
+}
+
+LogLevel Log::GetLevel()
+{
+	return static_cast<LogLevel>(minLevel.load(memory_order_relaxed));
+}
+
+void Log::SetFile(const std::string &file)
+{
+	fileName = file;
+}
+
+void Log::Write(LogLevel level, const std::string &message, std::initializer_list<LogField> fields)
+{
+	if (!IsEnabled(level))
+		return;
+
+	if (!running) {
+		Line line;
+		Format(line, level, message, fields);
+		lock_guard<mutex> lock(wakeMutex);
+		WriteLine(line);
+		fflush(stdout);
+		return;
+	}
+
+	ThreadRing *ring = GetThreadRing();
+	Line line;
+	Format(line, level, message, fields);
+	line.threadID = ring->threadID;
+
+	if (!ring->lines.TryPush(line)) {
+		dropped.fetch_add(1, memory_order_relaxed);
+		return;
+	}
+
+	// Without the lock a wake-up can be missed, the writer then finds the line on its timeout
+	if (sleeping.exchange(false))
+		wake.notify_one();
+}
+
+void Log::Debug(const std::string &message, std::initializer_list<LogField> fields)
+{
+	Write(LogLevel::DEBUG, message, fields);
+}
+
+void Log::Info(const std::string &message, std::initializer_list<LogField> fields)
+{
+	Write(LogLevel::INFO, message, fields);
+}
+
+void Log::Warn(const std::string &message, std::initializer_list<LogField> fields)
+{
+	Write(LogLevel::WARN, message, fields);
+}
+
+void Log::Error(const std::string &message, std::initializer_list<LogField> fields)
+{
+	Write(LogLevel::ERR, message, fields);
+}
+
+void Log::Report(const std::string &text)
+{
+	vector<string> lines;
+	istringstream stream(text);
+	string textLine;
+	while (getline(stream, textLine))
+		lines.push_back(textLine);
+
+	// One block of sequence numbers, lines of other threads are not written in the middle of it
+	uint64_t first = sequence.fetch_add(lines.size(), memory_order_relaxed);
+	ThreadRing *ring = running ? GetThreadRing() : nullptr;
+
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		Line line;
+		line.sequence = first + i;
+		line.time = Profiler::Now();
+		line.level = LogLevel::INFO;
+		line.report = true;
+		line.threadID = ring ? ring->threadID : 0;
+		LineWriter(line.text, LINE_SIZE).Append(lines[i].c_str());
+
+		if (!ring) {
+			lock_guard<mutex> lock(wakeMutex);
+			WriteLine(line);
+			continue;
+		}
+		while (!ring->lines.TryPush(line) && running)
+			Flush();
+	}
+
+	if (!ring)
+		fflush(stdout);
+	else if (sleeping.exchange(false))
+		wake.notify_one();
+}
+
+void Log::AppendFormat(std::string &text, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	va_list sizeArgs;
+	va_copy(sizeArgs, args);
+	int length = vsnprintf(nullptr, 0, format, sizeArgs);
+	va_end(sizeArgs);
+
+	if (length > 0) {
+		size_t start = text.size();
+		text.resize(start + length + 1);
+		vsnprintf(&text[start], length + 1, format, args);
+		text.resize(start + length);
+	}
+	va_end(args);
+}
+
+void Log::Flush()
+{
+	if (!running) {
+		fflush(stdout);
+		return;
+	}
+
+	// The pass running now may have missed lines logged just before, the one after it has not
+	unique_lock<mutex> lock(wakeMutex);
+	uint64_t target = passes + 2;
+	sleeping = false;
+	wake.notify_one();
+	drained.wait(lock, [target]() { return passes >= target || !running; });
+}
+
+uint64_t Log::GetDroppedCount()
+{
+	return dropped;
+}
+
+Log::ThreadRing* Log::GetThreadRing()
+{
+	static thread_local ThreadRing *ring = nullptr;
+	if (ring)
+		return ring;
+
+	// First line of this thread, the only time logging takes the lock
+	ring = new ThreadRing();
+
+	lock_guard<mutex> lock(ringsMutex);
+	ring->threadID = static_cast<unsigned int>(rings.size());
+	rings.push_back(ring);
+	return ring;
+}
+
+void Log::Format(Line &line, LogLevel level, const std::string &message, std::initializer_list<LogField> fields)
+{
+	line.sequence = sequence.fetch_add(1, memory_order_relaxed);
+	line.time = Profiler::Now();
+	line.level = level;
+	line.report = false;
+	line.threadID = 0;
+
+	LineWriter text(line.text, LINE_SIZE);
+	text.Append(message.c_str());
+	for (auto &field : fields)
+	{
+		text.Append(" ");
+		text.Append(field.key);
+		text.Append("=");
+		switch (field.type)
+		{
+			case LogField::STRING:
+				// Values with spaces are quoted so that the fields can be parsed back
+				if (strchr(field.value.text, ' ')) {
+					text.Append("\"");
+					text.Append(field.value.text);
+					text.Append("\"");
+				}
+				else {
+					text.Append(field.value.text);
+				}
+				break;
+			case LogField::INTEGER:
+				text.AppendFormat("%lld", field.value.integer);
+				break;
+			case LogField::REAL:
+				text.AppendFormat("%g", field.value.real);
+				break;
+		}
+	}
+}
+
+void Log::WriteLine(const Line &line)
+{
+	// The console keeps the game's messages as they were, problems get a prefix
+	if (line.report || line.level == LogLevel::INFO)
+		fprintf(stdout, "%s\n", line.text);
+	else
+		fprintf(stdout, "[%s] %s\n", LevelName(line.level), line.text);
+
+	if (file) {
+		const char *levelName = line.report ? "REPORT" : LevelName(line.level);
+		fprintf(file, "%.6f %-5s %u %s\n", line.time / 1e9, levelName, line.threadID, line.text);
+	}
+}
+
+bool Log::Drain(vector<Line> &batch)
+{
+	batch.clear();
+	{
+		lock_guard<mutex> lock(ringsMutex);
+		for (auto ring : rings)
+		{
+			batch.emplace_back();
+			while (ring->lines.TryPop(batch.back()))
+				batch.emplace_back();
+			batch.pop_back();
+		}
+	}
+
+	if (batch.empty())
+		return false;
+
+	// Threads are drained one after the other, the sequence restores the order the lines were logged in
+	vector<unsigned int> order(batch.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = static_cast<unsigned int>(i);
+	sort(order.begin(), order.end(), [&batch](unsigned int a, unsigned int b) {
+		return batch[a].sequence < batch[b].sequence;
+	});
+
+	for (auto index : order)
+		WriteLine(batch[index]);
+	fflush(stdout);
+	if (file)
+		fflush(file);
+	return true;
+}
+
+void Log::WriterLoop()
+{
+	Profiler::SetThreadName("Log");
+
+	vector<Line> batch;
+	while (running)
+	{
+		bool wrote = Drain(batch);
+
+		unique_lock<mutex> lock(wakeMutex);
+		passes++;
+		drained.notify_all();
+
+		// Sleeps only once a pass found nothing, a busy logger is drained back to back
+		if (!wrote && running) {
+			sleeping = true;
+			wake.wait_for(lock, WRITER_TIMEOUT);
+			sleeping = false;
+		}
+	}
+
+	lock_guard<mutex> lock(wakeMutex);
+	passes++;
+	drained.notify_all();
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Core/Threading/SPSCQueue.h>
+
+enum class LogLevel
+{
+	DEBUG,
+	INFO,
+	WARN,
+	// ERROR is a macro in the Windows headers
+	ERR
+};
+
+/*
+ *	Key / value attached to a line, written as key=value after the message
+ *	Only pointers are kept, fields must not outlive the Log call they are passed to
+ */
+
+class LogField
+{
+	public:
+		LogField(const char *key, const std::string &value) : key(key), type(STRING) { this->value.text = value.c_str(); }
+		LogField(const char *key, const char *value) : key(key), type(STRING) { this->value.text = value; }
+		LogField(const char *key, int value) : key(key), type(INTEGER) { this->value.integer = value; }
+		LogField(const char *key, unsigned int value) : key(key), type(INTEGER) { this->value.integer = value; }
+		LogField(const char *key, long value) : key(key), type(INTEGER) { this->value.integer = value; }
+		LogField(const char *key, unsigned long value) : key(key), type(INTEGER) { this->value.integer = value; }
+		LogField(const char *key, long long value) : key(key), type(INTEGER) { this->value.integer = value; }
+		LogField(const char *key, unsigned long long value) : key(key), type(INTEGER)
+		{
+			this->value.integer = static_cast<long long>(value);
+		}
+		LogField(const char *key, double value) : key(key), type(REAL) { this->value.real = value; }
+
+	private:
+		friend class Log;
+
+		const char *key;
+		enum { STRING, INTEGER, REAL } type;
+		union
+		{
+			const char *text;
+			long long integer;
+			double real;
+		} value;
+};
+
+/*
+ *	Asynchronous logger: Log::Info("Potted", {{"player", name}, {"balls", n}}) formats the line into a ring owned by
+ *	the calling thread and returns; a background thread writes the rings to stdout and to the log file
+ *	Logging takes no lock and does no I/O on the calling thread. A full ring drops the line and counts it instead of
+ *	waiting. Lines are written in the order they were logged, one stdout flush per batch
+ *	Before Init and after Exit lines are written synchronously
+ */
+
+class Log
+{
+	public:
+		// Lines waiting per thread
+		static const unsigned int RING_SIZE = 128;
+		// Longer lines are cut
+		static const unsigned int LINE_SIZE = 1024;
+
+		static void Init();
+		// Writes what is left and stops the writer thread
+		static void Exit();
+
+		// Lines below level are skipped before they are formatted, INFO by default
+		static void SetLevel(LogLevel level);
+		static LogLevel GetLevel();
+		static bool IsEnabled(LogLevel level)
+		{
+			return static_cast<int>(level) >= minLevel.load(std::memory_order_relaxed);
+		}
+
+		// Also writes every line with its time, level and thread to file, call before Init
+		static void SetFile(const std::string &file);
+
+		static void Write(LogLevel level, const std::string &message, std::initializer_list<LogField> fields = {});
+		static void Debug(const std::string &message, std::initializer_list<LogField> fields = {});
+		static void Info(const std::string &message, std::initializer_list<LogField> fields = {});
+		static void Warn(const std::string &message, std::initializer_list<LogField> fields = {});
+		static void Error(const std::string &message, std::initializer_list<LogField> fields = {});
+
+		// Preformatted multi-line block such as a stats table, written without a level prefix and kept whole.
+		// Not filtered by SetLevel. A full ring waits for the writer here rather than losing part of the block
+		static void Report(const std::string &text);
+		// printf into text, for building Report blocks
+		static void AppendFormat(std::string &text, const char *format, ...);
+
+		// Blocks until every line logged so far is written, before printing around the logger or reading stdin
+		static void Flush();
+
+		// Lines lost to full rings
+		static uint64_t GetDroppedCount();
+
+	protected:
+		Log() = delete;
+		~Log() = delete;
+
+	private:
+		struct Line
+		{
+			uint64_t sequence;
+			// Profiler::Now(), nanoseconds
+			uint64_t time;
+			LogLevel level;
+			// Line of a Report block, level is not used
+			bool report;
+			unsigned int threadID;
+			char text[LINE_SIZE];
+		};
+
+		struct ThreadRing
+		{
+			unsigned int threadID;
+			SPSCQueue<Line, RING_SIZE> lines;
+		};
+
+		static ThreadRing* GetThreadRing();
+		static void Format(Line &line, LogLevel level, const std::string &message,
+			std::initializer_list<LogField> fields);
+		static void WriteLine(const Line &line);
+		static void WriterLoop();
+		// Writes every line in the rings, true when there was any
+		static bool Drain(std::vector<Line> &batch);
+
+		static std::atomic<int> minLevel;
+		static std::atomic<bool> running;
+		static std::thread writer;
+		static std::string fileName;
+		static FILE *file;
+
+		static std::mutex ringsMutex;
+		// Rings outlive their threads, so that lines of finished threads are still written
+		static std::vector<ThreadRing*> rings;
+		static std::atomic<uint64_t> sequence;
+		static std::atomic<uint64_t> dropped;
+
+		// Writer sleeps while the rings are empty, the first line after that wakes it up
+		static std::atomic<bool> sleeping;
+		static std::mutex wakeMutex;
+		static std::condition_variable wake;
+		static std::condition_variable drained;
+		static uint64_t passes;
+};
@@ -0,0 +1,148 @@
+#include "AssetLoader.h"
+
+#include <chrono>
+#include <memory>
+
+#include <stb/stb_image.h>
+
+#include <include/utils.h>
+
+#include <Core/GPU/Mesh.h>
+#include <Core/GPU/Texture2D.h>
+#include <Core/Logging/Log.h>
+#include <Core/GPU/TextureCache.h>
+#include <Core/Profiling/StartupReport.h>
+#include <Core/Threading/ThreadPool.h>
+
+using namespace std;
+
+ThreadPool* AssetLoader::threadPool = nullptr;
+MPSCQueue<AssetLoader::UploadJob> AssetLoader::uploadQueue;
+atomic<unsigned int> AssetLoader::pendingCount(0);
+double AssetLoader::frameBudget = 0.004;
+
+void AssetLoader::Init(unsigned int nrThreads)
+{
+	if (threadPool)
+		return;
+
+	threadPool = new ThreadPool(nrThreads);
+	Log::Info("AssetLoader", { { "worker_threads", threadPool->GetThreadCount() } });
+}
+
+void AssetLoader::Exit()
+{
+	// Workers are joined first so nothing is pushed while the queue is drained
+	SAFE_FREE(threadPool);
+
+	UploadJob job;
+	while (uploadQueue.TryPop(job));
+	pendingCount = 0;
+}
+
+void AssetLoader::Submit(function<UploadJob()> job)
+{
+	pendingCount++;
+
+	if (threadPool == nullptr) {
+		// No workers, load in place
+		auto upload = job();
+		if (upload)
+			upload();
+		pendingCount--;
+		return;
+	}
+
+	threadPool->Enqueue([job]() {
+		uploadQueue.Push(job());
+	});
+}
+
+void AssetLoader::LoadMesh(Mesh *mesh, const string &fileLocation, const string &fileName)
+{
+	// The mesh must not be used by the render thread until its upload job ran
+	// Material texture references are given back here since TextureManager is not thread safe
+	mesh->ClearData();
+	Submit([mesh, fileLocation, fileName]() -> UploadJob {
+		if (!mesh->ImportMesh(fileLocation, fileName))
+			return nullptr;
+
+		return [mesh]() {
+			mesh->UploadMesh();
+		};
+	});
+}
+
+void AssetLoader::LoadTexture(Texture2D *texture, const string &fileName, GLenum wrappingMode, bool compress, function<void(bool)> onLoad)
+{
+	Submit([texture, fileName, wrappingMode, compress, onLoad]() -> UploadJob {
+		// Baked mip chain, uploaded level by level straight from the mapping
+		auto baked = make_shared<TextureLevels>();
+		if (TextureCache::Read(fileName, compress, *baked)) {
+			return [texture, baked, wrappingMode, onLoad]() {
+				texture->CreateFromLevels(baked->levels, baked->channels, baked->format, baked->compressed, wrappingMode);
+				if (onLoad) onLoad(true);
+			};
+		}
+
+		int width, height, chn;
+		StartupReport::AddFileRead(fileName);
+		shared_ptr<unsigned char> data(stbi_load(fileName.c_str(), &width, &height, &chn, 0), stbi_image_free);
+
+		if (data == nullptr) {
+			Log::Error("ERROR loading texture: " + fileName);
+			return [onLoad]() {
+				if (onLoad) onLoad(false);
+			};
+		}
+
+		// First load: the driver compresses and builds the mip chain, which is then baked for the next run
+		return [texture, fileName, data, width, height, chn, wrappingMode, compress, onLoad]() {
+			texture->CreateWithMipmaps(data.get(), width, height, chn, wrappingMode, compress);
+			TextureCache::Write(fileName, compress, texture);
+			if (onLoad) onLoad(true);
+		};
+	});
+}
+
+void AssetLoader::Update(double budget)
+{
+	auto startTime = chrono::high_resolution_clock::now();
+
+	UploadJob job;
+	while (uploadQueue.TryPop(job))
+	{
+		if (job)
+			job();
+		pendingCount--;
+
+		chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - startTime;
+		if (elapsed.count() >= budget)
+			break;
+	}
+}
+
+void AssetLoader::Update()
+{
+	Update(frameBudget);
+}
+
+void AssetLoader::SetFrameBudget(double seconds)
+{
+	frameBudget = seconds;
+}
+
+double AssetLoader::GetFrameBudget()
+{
+	return frameBudget;
+}
+
+unsigned int AssetLoader::GetPendingCount()
+{
+	return pendingCount;
+}
+
+ThreadPool* AssetLoader::GetThreadPool()
+{
+	return threadPool;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include <include/gl.h>
+
+#include <Core/Threading/MPSCQueue.h>
+
+class Mesh;
+class Texture2D;
+class ThreadPool;
+
+/*
+ *	Streams assets in the background
+ *	Parsing (Assimp) and image decoding (stb_image) run on worker threads, the finished CPU
+ *	buffers are queued and uploaded to the GPU by Update() on the render thread, within a
+ *	per-frame time budget. A mesh can be drawn once its GPU buffers exist (Mesh::IsLoaded)
+ */
+
+class AssetLoader
+{
+	public:
+		// nrThreads = 0 lets the thread pool pick the worker count
+		static void Init(unsigned int nrThreads = 0);
+		static void Exit();
+
+		static void LoadMesh(Mesh *mesh, const std::string &fileLocation, const std::string &fileName);
+		// compress requests block compression; the baked mip chain (TextureCache) is used when up to date
+		static void LoadTexture(Texture2D *texture, const std::string &fileName, GLenum wrappingMode = GL_REPEAT,
+								bool compress = false, std::function<void(bool)> onLoad = nullptr);
+
+		// Performs queued GPU uploads until the budget (seconds) is spent, at least one per call
+		static void Update(double budget);
+		static void Update();
+
+		static void SetFrameBudget(double seconds);
+		static double GetFrameBudget();
+
+		// Number of requested assets not yet uploaded
+		static unsigned int GetPendingCount();
+
+		// Worker pool shared by the engine for CPU side asset work
+		static ThreadPool* GetThreadPool();
+
+	protected:
+		AssetLoader() = delete;
+		~AssetLoader() = delete;
+
+	private:
+		// Runs on the render thread, may touch the OpenGL context
+		typedef std::function<void()> UploadJob;
+
+		static void Submit(std::function<UploadJob()> job);
+
+	private:
+		static ThreadPool *threadPool;
+		static MPSCQueue<UploadJob> uploadQueue;
+		static std::atomic<unsigned int> pendingCount;
+		static double frameBudget;
+};
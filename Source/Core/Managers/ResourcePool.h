@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+
+/*
+ *	Generational handle into a ResourcePool
+ *	A handle outlives its resource safely: once the slot is reused the generation no longer matches and Get() returns nullptr
+ */
+
+template <typename T>
+struct ResourceHandle
+{
+	static const unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+	ResourceHandle() : index(INVALID_INDEX), generation(0) {}
+	ResourceHandle(unsigned int index, unsigned int generation) : index(index), generation(generation) {}
+
+	bool IsValid() const { return index != INVALID_INDEX; }
+	bool operator==(const ResourceHandle &other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const ResourceHandle &other) const { return !(*this == other); }
+
+	unsigned int index;
+	unsigned int generation;
+};
+
+/*
+ *	Dense array of non-owning resource pointers addressed by generational handles
+ *	Handles are resolved once (by name, at init) so per-frame lookups are a bounds check and an array read
+ */
+
+template <typename T>
+class ResourcePool
+{
+	public:
+		typedef ResourceHandle<T> Handle;
+
+		Handle Add(T *resource)
+		{
+			unsigned int index;
+			if (freeSlots.empty()) {
+				index = static_cast<unsigned int>(resources.size());
+				resources.push_back(resource);
+				generations.push_back(0);
+			}
+			else {
+				index = freeSlots.back();
+				freeSlots.pop_back();
+				resources[index] = resource;
+			}
+			return Handle(index, generations[index]);
+		}
+
+		// The resource itself is not deleted, the slot is recycled and outstanding handles become stale
+		void Remove(Handle handle)
+		{
+			if (!Get(handle))
+				return;
+			resources[handle.index] = nullptr;
+			generations[handle.index]++;
+			freeSlots.push_back(handle.index);
+		}
+
+		T* Get(Handle handle) const
+		{
+			if (handle.index >= resources.size() || generations[handle.index] != handle.generation)
+				return nullptr;
+			return resources[handle.index];
+		}
+
+		// Raw slot access for iteration, removed slots hold nullptr
+		T* operator[](unsigned int index) const
+		{
+			return resources[index];
+		}
+
+		unsigned int GetSize() const
+		{
+			return static_cast<unsigned int>(resources.size());
+		}
+
+		void Clear()
+		{
+			resources.clear();
+			generations.clear();
+			freeSlots.clear();
+		}
+
+	private:
+		std::vector<T*> resources;
+		std::vector<unsigned int> generations;
+		std::vector<unsigned int> freeSlots;
+};
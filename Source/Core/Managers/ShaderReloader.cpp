@@ -0,0 +1,101 @@
+#include "ShaderReloader.h"
+
+#include <algorithm>
+
+#include <include/gl.h>
+#include <include/utils.h>
+#include <include/file_watcher.h>
+
+#include <Core/Engine.h>
+#include <Core/GPU/Shader.h>
+
+using namespace std;
+
+// Seconds between two polls of the watched files
+#define POLL_INTERVAL	0.25
+
+FileWatcher* ShaderReloader::watcher = nullptr;
+unordered_map<string, vector<Shader*>> ShaderReloader::watchedFiles;
+vector<Shader*> ShaderReloader::reloading;
+vector<string> ShaderReloader::changedFiles;
+double ShaderReloader::lastPollTime = 0;
+
+void ShaderReloader::Init()
+{
+	watcher = new FileWatcher();
+
+	if (GLEW_ARB_parallel_shader_compile)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+}
+
+void ShaderReloader::Exit()
+{
+	SAFE_FREE(watcher);
+	watchedFiles.clear();
+	reloading.clear();
+}
+
+void ShaderReloader::Watch(Shader *shader)
+{
+	if (!watcher)
+		return;
+
+	for (auto &file : shader->GetShaderFiles()) {
+		auto &shaders = watchedFiles[file];
+		if (find(shaders.begin(), shaders.end(), shader) == shaders.end())
+			shaders.push_back(shader);
+		watcher->Add(file);
+	}
+}
+
+void ShaderReloader::Unwatch(Shader *shader)
+{
+	for (auto it = watchedFiles.begin(); it != watchedFiles.end(); )
+	{
+		auto &shaders = it->second;
+		shaders.erase(remove(shaders.begin(), shaders.end(), shader), shaders.end());
+		if (shaders.empty()) {
+			if (watcher)
+				watcher->Remove(it->first);
+			it = watchedFiles.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	reloading.erase(remove(reloading.begin(), reloading.end(), shader), reloading.end());
+}
+
+void ShaderReloader::Reload(Shader *shader)
+{
+	shader->ReloadAsync();
+	if (find(reloading.begin(), reloading.end(), shader) == reloading.end())
+		reloading.push_back(shader);
+}
+
+void ShaderReloader::Update()
+{
+	double time = Engine::GetElapsedTime();
+	if (watcher && time - lastPollTime >= POLL_INTERVAL)
+	{
+		lastPollTime = time;
+		changedFiles.clear();
+		watcher->Poll(changedFiles);
+
+		for (auto &file : changedFiles) {
+			auto it = watchedFiles.find(file);
+			if (it == watchedFiles.end())
+				continue;
+			for (auto shader : it->second)
+				Reload(shader);
+		}
+	}
+
+	// Finished rebuilds are watched again, the set of included files may have changed
+	reloading.erase(remove_if(reloading.begin(), reloading.end(), [](Shader *shader) {
+		if (shader->UpdateReload())
+			return false;
+		Watch(shader);
+		return true;
+	}), reloading.end());
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class Shader;
+class FileWatcher;
+
+/*
+ *	Watches the source files of registered shaders and rebuilds a program when one of them is saved
+ *	Rebuilds go through Shader::ReloadAsync so the frame never waits on the compiler
+ */
+
+class ShaderReloader
+{
+	public:
+		// Needs the GL context, asks the driver for compiler threads when parallel shader compile is available
+		static void Init();
+		static void Exit();
+
+		static void Watch(Shader *shader);
+		static void Unwatch(Shader *shader);
+
+		// Starts a background rebuild regardless of file changes (F5)
+		static void Reload(Shader *shader);
+
+		// Called every frame: polls the watched files and advances the rebuilds in flight
+		static void Update();
+
+	protected:
+		ShaderReloader() = delete;
+		~ShaderReloader() = delete;
+
+	private:
+		static FileWatcher *watcher;
+		static std::unordered_map<std::string, std::vector<Shader*>> watchedFiles;
+		static std::vector<Shader*> reloading;
+		static std::vector<std::string> changedFiles;
+		static double lastPollTime;
+};
@@ -1,68 +1,202 @@
 #include "TextureManager.h"
 
+#include <algorithm>
+
 #include <include/utils.h>
 #include <Core/GPU/Texture2D.h>
+#include <Core/Logging/Log.h>
+#include <Core/Managers/AssetLoader.h>
 #include <Core/Managers/ResourcePath.h>
 
 using namespace std;
 
-std::unordered_map<std::string, Texture2D*> TextureManager::mapTextures;
-std::vector<Texture2D*> TextureManager::vTextures;
+std::unordered_map<std::string, TextureHandle> TextureManager::mapTextures;
+ResourcePool<Texture2D> TextureManager::textures;
+std::unordered_map<const Texture2D*, TextureManager::Residency> TextureManager::residency;
+size_t TextureManager::budget = 256 * 1024 * 1024;
+unsigned long long TextureManager::useClock = 0;
 
 void TextureManager::Init()
 {
-	LoadTexture(RESOURCE_PATH::TEXTURES, "default.png");
+	// The default texture stands in for every texture still being decoded, so it is loaded right away
+	Texture2D *defaultTexture = new Texture2D();
+	defaultTexture->Load2D((RESOURCE_PATH::TEXTURES + "default.png").c_str());
+	mapTextures["default.png"] = textures.Add(defaultTexture);
+
 	LoadTexture(RESOURCE_PATH::TEXTURES, "white.png");
 	LoadTexture(RESOURCE_PATH::TEXTURES, "black.jpg");
-	LoadTexture(RESOURCE_PATH::TEXTURES, "noise.png");
-	LoadTexture(RESOURCE_PATH::TEXTURES, "random.jpg");
+	LoadTexture(RESOURCE_PATH::TEXTURES, "noise.png", false);
+	LoadTexture(RESOURCE_PATH::TEXTURES, "random.jpg", false);
 	LoadTexture(RESOURCE_PATH::TEXTURES, "particle.png");
 }
 
-//TextureManager::~TextureManager()
-//{
-//	// delete textures
-//	unsigned int size = (unsigned int) vTextures.size();
-//	for (unsigned int i=0; i <size; ++i)
-//		SAFE_FREE(vTextures[i]);
-//}
+void TextureManager::Exit()
+{
+	for (unsigned int i = 0; i < textures.GetSize(); i++) {
+		Texture2D *texture = textures[i];
+		SAFE_FREE(texture);
+	}
+	textures.Clear();
+	mapTextures.clear();
+	residency.clear();
+}
 
-Texture2D* TextureManager::LoadTexture(const string &path, const char *fileName)
+Texture2D* TextureManager::LoadTexture(const string &path, const char *fileName, bool compress)
 {
-	Texture2D *texture = GetTexture(fileName);
+	// Requests for a file that is loaded or still in flight share the same handle
+	auto it = mapTextures.find(fileName);
+	Texture2D *loaded = (it != mapTextures.end()) ? textures.Get(it->second) : nullptr;
+	if (loaded) {
+		auto res = residency.find(loaded);
+		if (res != residency.end()) {
+			res->second.refCount++;
+			if (!loaded->GetTextureID() && !res->second.loading)
+				Reload(loaded, res->second);
+		}
+		return loaded;
+	}
+
+	// The handle has no GPU texture until the decode finishes and resolves to the default texture meanwhile
+	Texture2D *texture = new Texture2D();
+	mapTextures[fileName] = textures.Add(texture);
+
+	Residency &entry = residency[texture];
+	entry.name = fileName;
+	entry.file = path + '/' + fileName;
+	entry.compress = compress;
+	entry.refCount = 1;
+	entry.lastUse = ++useClock;
+	Reload(texture, entry);
+	return texture;
+}
+
+void TextureManager::Reload(Texture2D *texture, Residency &entry)
+{
+	entry.loading = true;
+	AssetLoader::LoadTexture(texture, entry.file, GL_REPEAT, entry.compress, [texture](bool) {
+		auto res = residency.find(texture);
+		if (res == residency.end())
+			return;
+		res->second.loading = false;
+		EnforceBudget();
+	});
+}
+
+void TextureManager::ReleaseTexture(Texture2D *texture)
+{
+	auto res = residency.find(texture);
+	if (res == residency.end() || res->second.refCount == 0)
+		return;
+
+	res->second.refCount--;
+	res->second.lastUse = ++useClock;
+	EnforceBudget();
+}
+
+void TextureManager::EnforceBudget()
+{
+	size_t residentBytes = GetResidentBytes();
+	if (residentBytes <= budget)
+		return;
+
+	vector<pair<unsigned long long, Texture2D*>> candidates;
+	for (unsigned int i = 0; i < textures.GetSize(); i++) {
+		Texture2D *texture = textures[i];
+		auto res = residency.find(texture);
+		if (texture && res != residency.end() && res->second.refCount == 0 && !res->second.loading && texture->GetTextureID())
+			candidates.push_back(make_pair(res->second.lastUse, texture));
+	}
+	sort(candidates.begin(), candidates.end());
 
-	if (texture) {
-		return mapTextures[fileName];
+	for (auto &candidate : candidates) {
+		if (residentBytes <= budget)
+			break;
+		residentBytes -= candidate.second->GetResidentBytes();
+		candidate.second->Release();
 	}
+}
+
+void TextureManager::SetBudget(size_t bytes)
+{
+	budget = bytes;
+	EnforceBudget();
+}
 
-	texture = new Texture2D();
-	bool status = texture->Load2D((path + '/' + fileName).c_str());
+size_t TextureManager::GetBudget()
+{
+	return budget;
+}
 
-	if (status == false) {
-		delete texture;
-		return vTextures[0];
+size_t TextureManager::GetResidentBytes()
+{
+	size_t bytes = 0;
+	for (unsigned int i = 0; i < textures.GetSize(); i++) {
+		if (textures[i])
+			bytes += textures[i]->GetResidentBytes();
 	}
+	return bytes;
+}
 
-	vTextures.push_back(texture);
-	mapTextures[fileName] = texture;
-	return texture;
+void TextureManager::PrintResidency()
+{
+	vector<pair<string, Texture2D*>> report;
+	for (auto &entry : mapTextures) {
+		Texture2D *texture = textures.Get(entry.second);
+		if (texture)
+			report.push_back(make_pair(entry.first, texture));
+	}
+	sort(report.begin(), report.end(), [](const pair<string, Texture2D*> &a, const pair<string, Texture2D*> &b) {
+		return a.second->GetResidentBytes() > b.second->GetResidentBytes();
+	});
+
+	string text;
+	Log::AppendFormat(text, "TEXTURES: %.2f / %.2f MB resident\n", GetResidentBytes() / 1048576.0, budget / 1048576.0);
+	for (auto &texture : report) {
+		auto res = residency.find(texture.second);
+		const char *state = "resident";
+		if (res == residency.end())
+			state = "pinned";
+		else if (res->second.loading)
+			state = "loading";
+		else if (!texture.second->GetTextureID())
+			state = "evicted";
+
+		Log::AppendFormat(text, "\t%-32s %10.1f KB  refs %-3u %s\n", texture.first.c_str(),
+			texture.second->GetResidentBytes() / 1024.0, res == residency.end() ? 1 : res->second.refCount, state);
+	}
+	Log::Report(text);
 }
 
 void TextureManager::SetTexture(string name, Texture2D *texture)
 {
-	mapTextures[name] = texture;
+	// Handles resolved for the previous texture go stale instead of silently switching
+	auto it = mapTextures.find(name);
+	if (it != mapTextures.end())
+		textures.Remove(it->second);
+	mapTextures[name] = textures.Add(texture);
+}
+
+TextureHandle TextureManager::GetTextureHandle(const char* name)
+{
+	auto it = mapTextures.find(name);
+	if (it != mapTextures.end())
+		return it->second;
+	return TextureHandle();
+}
+
+Texture2D* TextureManager::GetTexture(TextureHandle handle)
+{
+	return textures.Get(handle);
 }
 
 Texture2D* TextureManager::GetTexture(const char* name)
 {
-	if (mapTextures[name])
-		return mapTextures[name];
-	return NULL;
+	return textures.Get(GetTextureHandle(name));
 }
 
 Texture2D* TextureManager::GetTexture(unsigned int textureID)
 {
-	if (textureID < vTextures.size())
-		return vTextures[textureID];
+	if (textureID < textures.GetSize())
+		return textures[textureID];
 	return NULL;
 }
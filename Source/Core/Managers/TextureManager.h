@@ -4,14 +4,37 @@
 #include <string>
 #include <vector>
 
+#include <Core/Managers/ResourcePool.h>
+
 class Texture2D;
 
+typedef ResourceHandle<Texture2D> TextureHandle;
+
 class TextureManager
 {
 	public:
 		static void Init();
-		static Texture2D* LoadTexture(const std::string &Path, const char *fileName);
+		static void Exit();
+
+		// Returns immediately, the image is decoded on the loader threads and uploaded by AssetLoader::Update
+		// Until then the handle has no GPU texture and binding code falls back to the default texture (ID 0)
+		// compress stores the texture block compressed (BC1/BC3/RGTC), keep it off for data textures
+		// Every call takes a reference that must be given back with ReleaseTexture
+		static Texture2D* LoadTexture(const std::string &Path, const char *fileName, bool compress = true);
+
+		// Unreferenced textures stay resident until the budget is exceeded, then the least recently released go first
+		// An evicted texture keeps its handle and is loaded again by the next LoadTexture
+		static void ReleaseTexture(Texture2D *texture);
+		static void SetBudget(size_t bytes);
+		static size_t GetBudget();
+		static size_t GetResidentBytes();
+		static void PrintResidency();
+
 		static void SetTexture(const std::string name, Texture2D * texture);
+
+		// Resolve the handle once and use GetTexture(handle) on the hot path, it skips the name lookup
+		static TextureHandle GetTextureHandle(const char* name);
+		static Texture2D* GetTexture(TextureHandle handle);
 		static Texture2D* GetTexture(const char* name);
 		static Texture2D* GetTexture(unsigned int textureID);
 
@@ -20,7 +43,23 @@ class TextureManager
 		~TextureManager() = delete;
 
 	private:
+		struct Residency
+		{
+			std::string name;
+			std::string file;
+			bool compress;
+			unsigned int refCount;
+			unsigned long long lastUse;
+			bool loading;
+		};
 
-		static std::unordered_map<std::string, Texture2D*> mapTextures;
-		static std::vector<Texture2D*> vTextures;
+		static void Reload(Texture2D *texture, Residency &residency);
+		static void EnforceBudget();
+
+	private:
+		static std::unordered_map<std::string, TextureHandle> mapTextures;
+		static ResourcePool<Texture2D> textures;
+		static std::unordered_map<const Texture2D*, Residency> residency;
+		static size_t budget;
+		static unsigned long long useClock;
 };
\ No newline at end of file
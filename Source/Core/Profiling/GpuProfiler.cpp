@@ -0,0 +1,375 @@
+#include "GpuProfiler.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <Core/Engine.h>
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/StartupReport.h>
+
+using namespace std;
+
+// Seconds between window title refreshes
+#define TITLE_UPDATE_INTERVAL	0.5
+// GPU time spanning a quarter of the window width in the overlay
+#define OVERLAY_FULL_SCALE_MS	16.667
+
+bool GpuProfiler::enabled = false;
+bool GpuProfiler::recording = false;
+bool GpuProfiler::timerQueries = false;
+GpuProfiler::FrameSlot GpuProfiler::frames[GpuProfiler::FRAME_LATENCY];
+unsigned long long GpuProfiler::frameID = 0;
+int GpuProfiler::activePass = -1;
+std::vector<GpuProfiler::PassStats> GpuProfiler::lastFrame;
+unsigned long long GpuProfiler::lastFrameID = 0;
+FILE* GpuProfiler::log = nullptr;
+double GpuProfiler::lastTitleUpdate = 0;
+
+namespace
+{
+	const glm::vec3 passColors[] = {
+		glm::vec3(0.90f, 0.30f, 0.25f),
+		glm::vec3(0.25f, 0.65f, 0.90f),
+		glm::vec3(0.35f, 0.80f, 0.35f),
+		glm::vec3(0.95f, 0.75f, 0.20f),
+		glm::vec3(0.70f, 0.45f, 0.90f),
+		glm::vec3(0.90f, 0.55f, 0.80f),
+	};
+
+	unsigned long long CountTriangles(GLenum mode, unsigned long long count)
+	{
+		switch (mode)
+		{
+			case GL_TRIANGLES:
+				return count / 3;
+			case GL_TRIANGLE_STRIP:
+			case GL_TRIANGLE_FAN:
+				return count > 2 ? count - 2 : 0;
+			default:
+				return 0;
+		}
+	}
+}
+
+void GpuProfiler::Init()
+{
+	timerQueries = false;
+	if (GLEW_VERSION_3_3 || GLEW_ARB_timer_query)
+	{
+		// A counter without bits means the driver exposes the query but cannot time anything
+		GLint bits = 0;
+		glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+		timerQueries = bits > 0;
+	}
+	CheckOpenGLError();
+
+	if (!timerQueries)
+		Log::Warn("[GpuProfiler] Timer queries not supported, only draw counters will be reported");
+
+	// Lets CI runs profile without a key press
+	const char *env = getenv("EGC_GPU_PROFILE");
+	if (env && strcmp(env, "0") != 0)
+		SetEnabled(true);
+}
+
+void GpuProfiler::Exit()
+{
+	for (auto &slot : frames) {
+		if (!slot.queries.empty())
+			glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+		slot.queries.clear();
+		slot.passes.clear();
+		slot.pending = false;
+	}
+
+	if (log)
+		fclose(log);
+	log = nullptr;
+}
+
+void GpuProfiler::SetEnabled(bool enabled)
+{
+	// Takes effect on the next BeginFrame, a frame is either fully recorded or not at all
+	GpuProfiler::enabled = enabled;
+
+	if (!enabled) {
+		WindowObject *window = Engine::GetWindow();
+		if (window)
+			window->SetTitle(window->props.name);
+	}
+}
+
+bool GpuProfiler::IsEnabled()
+{
+	return enabled;
+}
+
+void GpuProfiler::BeginFrame()
+{
+	recording = enabled;
+	frameID++;
+
+	FrameSlot &slot = frames[frameID % FRAME_LATENCY];
+	if (slot.pending)
+		ReadBack(slot);
+
+	slot.frameID = frameID;
+	slot.pending = false;
+	slot.passes.clear();
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (activePass >= 0)
+		EndPass();
+
+	FrameSlot &slot = frames[frameID % FRAME_LATENCY];
+	slot.pending = recording && !slot.passes.empty();
+	recording = false;
+}
+
+void GpuProfiler::BeginPass(const char *name)
+{
+	if (!recording)
+		return;
+
+	// GL_TIME_ELAPSED queries cannot nest, an unbalanced pass is closed here
+	if (activePass >= 0)
+		EndPass();
+
+	FrameSlot &slot = frames[frameID % FRAME_LATENCY];
+
+	// Every invocation gets its own query, ReadBack merges passes sharing a name
+	PassStats pass;
+	pass.name = name;
+	pass.gpuMs = -1;
+	pass.drawCalls = 0;
+	pass.triangles = 0;
+	pass.stateChanges = 0;
+	slot.passes.push_back(pass);
+	activePass = static_cast<int>(slot.passes.size()) - 1;
+
+	if (timerQueries)
+	{
+		if (slot.queries.size() < slot.passes.size()) {
+			GLuint query;
+			glGenQueries(1, &query);
+			StartupReport::AddGLObjects(StartupReport::GL_OBJECT_QUERY);
+			slot.queries.push_back(query);
+		}
+		glBeginQuery(GL_TIME_ELAPSED, slot.queries[activePass]);
+	}
+}
+
+void GpuProfiler::EndPass()
+{
+	if (activePass < 0)
+		return;
+
+	if (timerQueries)
+		glEndQuery(GL_TIME_ELAPSED);
+	activePass = -1;
+}
+
+void GpuProfiler::CountDraw(GLenum mode, unsigned long long count)
+{
+	if (activePass < 0)
+		return;
+
+	PassStats &pass = frames[frameID % FRAME_LATENCY].passes[activePass];
+	pass.drawCalls++;
+	pass.triangles += CountTriangles(mode, count);
+}
+
+void GpuProfiler::CountMultiDraw(GLenum mode, const GLsizei *counts, unsigned int nrDraws)
+{
+	if (activePass < 0)
+		return;
+
+	PassStats &pass = frames[frameID % FRAME_LATENCY].passes[activePass];
+	pass.drawCalls++;
+	for (unsigned int i = 0; i < nrDraws; i++)
+		pass.triangles += CountTriangles(mode, counts[i]);
+}
+
+void GpuProfiler::CountStateChange(unsigned int changes)
+{
+	if (activePass < 0)
+		return;
+
+	frames[frameID % FRAME_LATENCY].passes[activePass].stateChanges += changes;
+}
+
+const std::vector<GpuProfiler::PassStats>& GpuProfiler::GetLastFrame()
+{
+	return lastFrame;
+}
+
+unsigned long long GpuProfiler::GetLastFrameID()
+{
+	return lastFrameID;
+}
+
+unsigned long long GpuProfiler::GetFrameID()
+{
+	return frameID;
+}
+
+void GpuProfiler::ReadBack(FrameSlot &slot)
+{
+	slot.pending = false;
+
+	if (timerQueries)
+	{
+		// Queries complete in submission order, the last one being ready means all of them are
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(slot.queries[slot.passes.size() - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return;
+
+		for (size_t i = 0; i < slot.passes.size(); i++) {
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &elapsed);
+			slot.passes[i].gpuMs = elapsed / 1000000.0;
+		}
+	}
+
+	lastFrame.clear();
+	for (auto &pass : slot.passes)
+	{
+		PassStats *merged = nullptr;
+		for (auto &other : lastFrame) {
+			if (strcmp(other.name, pass.name) == 0)
+				merged = &other;
+		}
+
+		if (!merged) {
+			lastFrame.push_back(pass);
+			continue;
+		}
+
+		if (pass.gpuMs >= 0)
+			merged->gpuMs += pass.gpuMs;
+		merged->drawCalls += pass.drawCalls;
+		merged->triangles += pass.triangles;
+		merged->stateChanges += pass.stateChanges;
+	}
+	lastFrameID = slot.frameID;
+
+	WriteLog(slot);
+}
+
+void GpuProfiler::WriteLog(const FrameSlot &slot)
+{
+	if (!log) {
+		log = fopen(GPU_PROFILER_LOG_FILE, "w");
+		if (!log) {
+			Log::Error("[GpuProfiler] Could not write " GPU_PROFILER_LOG_FILE);
+			return;
+		}
+	}
+
+	double totalMs = 0;
+	unsigned int drawCalls = 0, stateChanges = 0;
+	unsigned long long triangles = 0;
+	for (auto &pass : lastFrame) {
+		totalMs += pass.gpuMs;
+		drawCalls += pass.drawCalls;
+		triangles += pass.triangles;
+		stateChanges += pass.stateChanges;
+	}
+
+	fprintf(log, "{\"frame\":%llu,\"gpu_ms\":", slot.frameID);
+	if (timerQueries)
+		fprintf(log, "%.4f", totalMs);
+	else
+		fprintf(log, "null");
+	fprintf(log, ",\"draw_calls\":%u,\"triangles\":%llu,\"state_changes\":%u,\"passes\":[", drawCalls, triangles, stateChanges);
+
+	for (size_t i = 0; i < lastFrame.size(); i++)
+	{
+		const PassStats &pass = lastFrame[i];
+		fprintf(log, "%s{\"name\":\"%s\",\"gpu_ms\":", i ? "," : "", pass.name);
+		if (timerQueries)
+			fprintf(log, "%.4f", pass.gpuMs);
+		else
+			fprintf(log, "null");
+		fprintf(log, ",\"draw_calls\":%u,\"triangles\":%llu,\"state_changes\":%u}", pass.drawCalls, pass.triangles, pass.stateChanges);
+	}
+	fprintf(log, "]}\n");
+}
+
+void GpuProfiler::UpdateTitle()
+{
+	WindowObject *window = Engine::GetWindow();
+	double now = Engine::GetElapsedTime();
+	if (!window || now - lastTitleUpdate < TITLE_UPDATE_INTERVAL)
+		return;
+	lastTitleUpdate = now;
+
+	double totalMs = 0;
+	unsigned int drawCalls = 0, stateChanges = 0;
+	unsigned long long triangles = 0;
+	string passes;
+	char text[128];
+	for (auto &pass : lastFrame)
+	{
+		totalMs += pass.gpuMs;
+		drawCalls += pass.drawCalls;
+		triangles += pass.triangles;
+		stateChanges += pass.stateChanges;
+
+		if (timerQueries) {
+			snprintf(text, sizeof(text), " | %s %.2f", pass.name, pass.gpuMs);
+			passes += text;
+		}
+	}
+
+	if (timerQueries)
+		snprintf(text, sizeof(text), " | GPU %.2f ms, %u draws, %llu tris, %u state changes", totalMs, drawCalls, triangles, stateChanges);
+	else
+		snprintf(text, sizeof(text), " | %u draws, %llu tris, %u state changes", drawCalls, triangles, stateChanges);
+
+	window->SetTitle(window->props.name + text + passes);
+}
+
+void GpuProfiler::DrawOverlay(glm::ivec2 resolution)
+{
+	if (!enabled || lastFrame.empty())
+		return;
+
+	UpdateTitle();
+
+	if (!timerQueries)
+		return;
+
+	// Scissored clears draw the bars without touching any shader, buffer or vertex state
+	GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	glEnable(GL_SCISSOR_TEST);
+
+	const int margin = 8, barHeight = 6, gap = 2;
+	const float pixelsPerMs = resolution.x / 4.0f / static_cast<float>(OVERLAY_FULL_SCALE_MS);
+	int panelHeight = static_cast<int>(lastFrame.size()) * (barHeight + gap) + gap;
+
+	glScissor(margin, margin, resolution.x / 4 + 2 * gap, panelHeight);
+	glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	for (size_t i = 0; i < lastFrame.size(); i++)
+	{
+		int width = static_cast<int>(lastFrame[i].gpuMs * pixelsPerMs);
+		if (width <= 0)
+			continue;
+
+		const glm::vec3 &color = passColors[i % (sizeof(passColors) / sizeof(passColors[0]))];
+		glScissor(margin + gap, margin + gap + static_cast<int>(i) * (barHeight + gap), MIN(width, resolution.x / 4), barHeight);
+		glClearColor(color.r, color.g, color.b, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+	if (!scissorTest)
+		glDisable(GL_SCISSOR_TEST);
+}
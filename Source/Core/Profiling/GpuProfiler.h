@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <include/gl.h>
+#include <include/glm.h>
+
+// Per-frame GPU statistics, one JSON object per line
+#define GPU_PROFILER_LOG_FILE	"gpu_frames.jsonl"
+
+/*
+ *	GPU pass timing: GPU_PASS("name") wraps the enclosing block in a GL_TIME_ELAPSED query and counts the draw calls,
+ *	triangles and state changes issued inside it
+ *	Queries are read FRAME_LATENCY frames later, a frame whose results are still not available is dropped instead
+ *	of stalling the pipeline. Only one GL_TIME_ELAPSED query can be active at a time, so passes must not nest
+ *	Without ARB_timer_query (some software rasterizers) the counters are still reported, the GPU times are not
+ */
+
+class GpuProfiler
+{
+	public:
+		// Frames recorded before their queries are read back
+		static const unsigned int FRAME_LATENCY = 4;
+
+		struct PassStats
+		{
+			const char *name;
+			// Negative when timer queries are not available
+			double gpuMs;
+			unsigned int drawCalls;
+			unsigned long long triangles;
+			unsigned int stateChanges;
+		};
+
+		// Needs the GL context
+		static void Init();
+		static void Exit();
+
+		// Collects timings and counters, shows them in the overlay and appends them to GPU_PROFILER_LOG_FILE
+		static void SetEnabled(bool enabled);
+		static bool IsEnabled();
+
+		static void BeginFrame();
+		static void EndFrame();
+
+		// name must be a string literal, passes are told apart by it
+		static void BeginPass(const char *name);
+		static void EndPass();
+
+		// Counted against the open pass, ignored outside of passes
+		static void CountDraw(GLenum mode, unsigned long long count);
+		// One call drawing several ranges (glMultiDraw*)
+		static void CountMultiDraw(GLenum mode, const GLsizei *counts, unsigned int nrDraws);
+		static void CountStateChange(unsigned int changes = 1);
+
+		// Stats of the most recent frame whose queries were read back
+		static const std::vector<PassStats>& GetLastFrame();
+		// Id of that frame, compare with GetFrameID() of the frame that recorded it
+		static unsigned long long GetLastFrameID();
+		// Id of the frame started by the last BeginFrame
+		static unsigned long long GetFrameID();
+
+		// Bar per pass (width proportional to its GPU time) in the lower left corner, numbers in the window title
+		static void DrawOverlay(glm::ivec2 resolution);
+
+	protected:
+		GpuProfiler() = delete;
+		~GpuProfiler() = delete;
+
+	private:
+		struct FrameSlot
+		{
+			unsigned long long frameID;
+			bool pending;
+			std::vector<PassStats> passes;
+			std::vector<GLuint> queries;
+		};
+
+		static void ReadBack(FrameSlot &slot);
+		static void WriteLog(const FrameSlot &slot);
+		static void UpdateTitle();
+
+		static bool enabled;
+		// enabled as sampled by BeginFrame
+		static bool recording;
+		static bool timerQueries;
+		static FrameSlot frames[FRAME_LATENCY];
+		static unsigned long long frameID;
+		static int activePass;
+		static std::vector<PassStats> lastFrame;
+		static unsigned long long lastFrameID;
+		static FILE *log;
+		static double lastTitleUpdate;
+};
+
+class GpuPassScope
+{
+	public:
+		explicit GpuPassScope(const char *name)
+		{
+			GpuProfiler::BeginPass(name);
+		}
+
+		~GpuPassScope()
+		{
+			GpuProfiler::EndPass();
+		}
+
+		GpuPassScope(const GpuPassScope&) = delete;
+		GpuPassScope& operator=(const GpuPassScope&) = delete;
+};
+
+#define GPU_PASS_CONCAT_IMPL(a, b) a##b
+#define GPU_PASS_CONCAT(a, b) GPU_PASS_CONCAT_IMPL(a, b)
+
+#ifdef DISABLE_PROFILER
+	#define GPU_PASS(name)
+#else
+	#define GPU_PASS(name) GpuPassScope GPU_PASS_CONCAT(gpuPassScope, __LINE__)(name)
+#endif
@@ -0,0 +1,184 @@
+#include "LatencyTracker.h"
+
+#include <algorithm>
+
+#include <Core/Engine.h>
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/StartupReport.h>
+#include <Core/Profiling/Statistics.h>
+
+using namespace std;
+
+atomic<bool> LatencyTracker::enabled(false);
+bool LatencyTracker::timestamps = false;
+LatencyTracker::Slot LatencyTracker::slots[LatencyTracker::SLOTS];
+unsigned int LatencyTracker::nextSlot = 0;
+LatencyTracker::Sample LatencyTracker::frame = { -1, 0, 0, 0 };
+double LatencyTracker::clockOffset = 0;
+vector<LatencyTracker::Sample> LatencyTracker::samples;
+unsigned int LatencyTracker::nextSample = 0;
+unsigned int LatencyTracker::droppedFrames = 0;
+
+void LatencyTracker::Init()
+{
+	timestamps = false;
+	if (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) {
+		GLint bits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+		timestamps = bits > 0;
+	}
+
+	for (auto &slot : slots) {
+		slot.query = 0;
+		slot.pending = false;
+	}
+
+	if (timestamps) {
+		for (auto &slot : slots)
+			glGenQueries(1, &slot.query);
+		StartupReport::AddGLObjects(StartupReport::GL_OBJECT_QUERY, SLOTS);
+	}
+	CheckOpenGLError();
+}
+
+void LatencyTracker::Exit()
+{
+	if (enabled)
+		PrintReport();
+
+	for (auto &slot : slots) {
+		if (slot.query)
+			glDeleteQueries(1, &slot.query);
+		slot.query = 0;
+		slot.pending = false;
+	}
+}
+
+void LatencyTracker::SetEnabled(bool enabled)
+{
+	if (enabled && !timestamps) {
+		Log::Warn("[LatencyTracker] Timer queries not supported, latency cannot be measured");
+		return;
+	}
+
+	LatencyTracker::enabled = enabled;
+	if (enabled)
+		Log::Info("[LatencyTracker] Measuring input latency");
+}
+
+bool LatencyTracker::IsEnabled()
+{
+	return enabled.load(memory_order_relaxed);
+}
+
+void LatencyTracker::MarkFrame(double inputTime, double appliedTime)
+{
+	if (!enabled)
+		return;
+
+	// Several inputs shown for the first time: the oldest one waited the longest
+	if (frame.input < 0 || inputTime < frame.input) {
+		frame.input = inputTime;
+		frame.applied = appliedTime;
+	}
+}
+
+void LatencyTracker::EndFrame()
+{
+	if (!timestamps)
+		return;
+
+	for (auto &slot : slots)
+		if (slot.pending)
+			ReadBack(slot);
+
+	if (!enabled || frame.input < 0)
+		return;
+
+	Slot &slot = slots[nextSlot];
+	if (slot.pending) {
+		// The GPU is SLOTS frames behind, not worth a stall
+		droppedFrames++;
+		frame.input = -1;
+		return;
+	}
+	nextSlot = (nextSlot + 1) % SLOTS;
+
+	glQueryCounter(slot.query, GL_TIMESTAMP);
+	slot.pending = true;
+	slot.sample = frame;
+	slot.sample.submitted = Engine::GetElapsedTime();
+	frame.input = -1;
+
+	// Returns the time the GPU has reached without waiting for it, the clocks drift, so the offset is kept fresh
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	clockOffset = Engine::GetElapsedTime() - gpuNow / 1e9;
+}
+
+void LatencyTracker::ReadBack(Slot &slot)
+{
+	GLuint available = 0;
+	glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+
+	GLuint64 gpuTime = 0;
+	glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &gpuTime);
+	slot.pending = false;
+	if (!enabled)
+		return;
+
+	// A frame done before the CPU handed it over means the offset was sampled late, it still finished then
+	Sample sample = slot.sample;
+	sample.presented = std::max(gpuTime / 1e9 + clockOffset, sample.submitted);
+
+	if (samples.size() < MAX_SAMPLES)
+		samples.push_back(sample);
+	else
+		samples[nextSample] = sample;
+	nextSample = (nextSample + 1) % MAX_SAMPLES;
+}
+
+void LatencyTracker::PrintReport()
+{
+	string text = "=====================================================\n";
+	if (samples.empty()) {
+		text += "Input latency: no frames measured\n";
+		Log::Report(text);
+		return;
+	}
+
+	Log::AppendFormat(text, "Input latency, %u frames", static_cast<unsigned int>(samples.size()));
+	if (droppedFrames)
+		Log::AppendFormat(text, " (%u dropped)", droppedFrames);
+	text += "\n       p50 ms    p90 ms    p99 ms    max ms  stage\n";
+
+	vector<double> values(samples.size());
+	auto printStage = [&values, &text](const char *name) {
+		sort(values.begin(), values.end());
+		Log::AppendFormat(text, "%12.2f %9.2f %9.2f %9.2f  %s\n", Percentile(values, 50) * 1000,
+			Percentile(values, 90) * 1000, Percentile(values, 99) * 1000, values.back() * 1000, name);
+	};
+
+	for (size_t i = 0; i < samples.size(); i++)
+		values[i] = samples[i].applied - samples[i].input;
+	printStage("input > simulation");
+	for (size_t i = 0; i < samples.size(); i++)
+		values[i] = samples[i].submitted - samples[i].applied;
+	printStage("simulation > swap");
+	for (size_t i = 0; i < samples.size(); i++)
+		values[i] = samples[i].presented - samples[i].submitted;
+	printStage("swap > GPU done");
+	for (size_t i = 0; i < samples.size(); i++)
+		values[i] = samples[i].presented - samples[i].input;
+	printStage("total");
+	Log::Report(text);
+}
+
+void LatencyTracker::Clear()
+{
+	samples.clear();
+	nextSample = 0;
+	droppedFrames = 0;
+}
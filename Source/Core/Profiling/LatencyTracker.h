@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <include/gl.h>
+
+/*
+ *	Input-to-photon latency: from the GLFW callback of an input to the moment the GPU finished the first frame
+ *	showing its effect
+ *	The scene reports which input the frame being drawn reflects first (MarkFrame); EndFrame, after SwapBuffers,
+ *	puts a GL_TIMESTAMP query behind the frame. Results are read SLOTS frames later at the latest, without waiting
+ *	(a frame still in flight when its slot comes around again is dropped), and converted to the CPU clock with an
+ *	offset sampled from glGetInteger64v(GL_TIMESTAMP)
+ *	The estimate ends when the swap was handed to the display: vsync and compositor add up to a refresh on top
+ */
+
+class LatencyTracker
+{
+	public:
+		static const unsigned int SLOTS = 8;
+		// Samples kept for the percentiles, the oldest are overwritten
+		static const unsigned int MAX_SAMPLES = 4096;
+
+		// Needs the GL context
+		static void Init();
+		static void Exit();
+
+		// Callable from any thread, so that producers can skip the bookkeeping while disabled
+		static void SetEnabled(bool enabled);
+		static bool IsEnabled();
+
+		// Render thread: the frame being drawn is the first to show input received at inputTime and applied at
+		// appliedTime (Engine::GetElapsedTime() clock)
+		static void MarkFrame(double inputTime, double appliedTime);
+		// Render thread, right after SwapBuffers
+		static void EndFrame();
+
+		// Percentiles of the samples collected since the last Clear
+		static void PrintReport();
+		static void Clear();
+
+	protected:
+		LatencyTracker() = delete;
+		~LatencyTracker() = delete;
+
+	private:
+		struct Sample
+		{
+			double input;
+			double applied;
+			double submitted;
+			double presented;
+		};
+
+		struct Slot
+		{
+			GLuint query;
+			bool pending;
+			Sample sample;
+		};
+
+		static void ReadBack(Slot &slot);
+
+		static std::atomic<bool> enabled;
+		static bool timestamps;
+		static Slot slots[SLOTS];
+		static unsigned int nextSlot;
+
+		// Mark of the frame in progress, input < 0 when it shows no new input
+		static Sample frame;
+		// Offset from GPU timestamps to the CPU clock, in seconds
+		static double clockOffset;
+
+		static std::vector<Sample> samples;
+		static unsigned int nextSample;
+		static unsigned int droppedFrames;
+};
@@ -0,0 +1,133 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include <Core/Logging/Log.h>
+
+using namespace std;
+
+std::atomic<bool> Profiler::enabled(false);
+std::mutex Profiler::ringsMutex;
+std::vector<Profiler::ThreadRing*> Profiler::rings;
+
+namespace
+{
+	const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+	void WriteEscaped(FILE *out, const char *text)
+	{
+		for (; *text; text++) {
+			if (*text == '"' || *text == '\\')
+				fputc('\\', out);
+			fputc(*text, out);
+		}
+	}
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+	Profiler::enabled.store(enabled, memory_order_relaxed);
+}
+
+uint64_t Profiler::Now()
+{
+	return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count());
+}
+
+Profiler::ThreadRing* Profiler::GetThreadRing()
+{
+	static thread_local ThreadRing *ring = nullptr;
+	if (ring)
+		return ring;
+
+	// First event of this thread, the only time recording takes the lock
+	ring = new ThreadRing();
+	ring->events.resize(RING_SIZE);
+	ring->written.store(0, memory_order_relaxed);
+
+	lock_guard<mutex> lock(ringsMutex);
+	ring->threadID = static_cast<unsigned int>(rings.size());
+	ring->name = "Thread " + to_string(ring->threadID);
+	rings.push_back(ring);
+	return ring;
+}
+
+void Profiler::SetThreadName(const std::string &name)
+{
+	ThreadRing *ring = GetThreadRing();
+	lock_guard<mutex> lock(ringsMutex);
+	ring->name = name;
+}
+
+void Profiler::Record(const char *name, uint64_t start, uint64_t end)
+{
+	ThreadRing *ring = GetThreadRing();
+	uint64_t index = ring->written.load(memory_order_relaxed);
+
+	Event &event = ring->events[index & (RING_SIZE - 1)];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+
+	ring->written.store(index + 1, memory_order_release);
+}
+
+void Profiler::Clear()
+{
+	lock_guard<mutex> lock(ringsMutex);
+	for (auto ring : rings)
+		ring->written.store(0, memory_order_release);
+}
+
+bool Profiler::ExportChromeTrace(const std::string &file)
+{
+	FILE *out = fopen(file.c_str(), "w");
+	if (!out) {
+		Log::Error("[Profiler] Could not write " + file);
+		return false;
+	}
+
+	// Scopes that are already open when recording stops may still land in a ring, at worst one event reads torn
+	bool wasEnabled = IsEnabled();
+	SetEnabled(false);
+
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+	size_t nrEvents = 0;
+	bool first = true;
+	{
+		lock_guard<mutex> lock(ringsMutex);
+		for (auto ring : rings)
+		{
+			fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", ring->threadID);
+			WriteEscaped(out, ring->name.c_str());
+			fprintf(out, "\"}}");
+			first = false;
+
+			uint64_t written = ring->written.load(memory_order_acquire);
+			uint64_t begin = written > RING_SIZE ? written - RING_SIZE : 0;
+			for (uint64_t i = begin; i < written; i++)
+			{
+				const Event &event = ring->events[i & (RING_SIZE - 1)];
+
+				// Complete events, timestamps in microseconds
+				fprintf(out, ",\n{\"name\":\"");
+				WriteEscaped(out, event.name);
+				fprintf(out, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					ring->threadID, event.start / 1000.0, (event.end - event.start) / 1000.0);
+				nrEvents++;
+			}
+		}
+	}
+
+	fprintf(out, "\n]}\n");
+	bool ok = ferror(out) == 0;
+	fclose(out);
+
+	SetEnabled(wasEnabled);
+
+	Log::Info("[Profiler] Trace written to " + file, { { "events", static_cast<unsigned long long>(nrEvents) } });
+	return ok;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Captures started with F7 are written here when they stop (or when the engine exits)
+#define PROFILER_TRACE_FILE	"frame_trace.json"
+
+/*
+ *	CPU frame profiler: PROFILE_SCOPE("name") records how long the enclosing block took
+ *	Every thread writes to its own ring buffer, so recording takes no lock. Old events are overwritten when a ring is full
+ *	While recording is off a scope costs one relaxed atomic load; building with DISABLE_PROFILER removes the scopes entirely
+ *	Export writes the Chrome trace event format, open it in chrome://tracing or https://ui.perfetto.dev
+ */
+
+class Profiler
+{
+	public:
+		// Events kept per thread, the most recent ones win
+		static const unsigned int RING_SIZE = 1 << 16;
+
+		struct Event
+		{
+			// Must point to a string literal, only the pointer is stored
+			const char *name;
+			uint64_t start;
+			uint64_t end;
+		};
+
+		static void SetEnabled(bool enabled);
+		static bool IsEnabled()
+		{
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		// Nanoseconds since the profiler was first used
+		static uint64_t Now();
+
+		// Labels the calling thread in the exported trace
+		static void SetThreadName(const std::string &name);
+
+		static void Record(const char *name, uint64_t start, uint64_t end);
+
+		// Drops every recorded event
+		static void Clear();
+
+		// Writes the events of all threads, pausing recording while it reads the rings
+		static bool ExportChromeTrace(const std::string &file);
+
+	protected:
+		Profiler() = delete;
+		~Profiler() = delete;
+
+	private:
+		struct ThreadRing
+		{
+			unsigned int threadID;
+			std::string name;
+			std::vector<Event> events;
+			std::atomic<uint64_t> written;
+		};
+
+		static ThreadRing* GetThreadRing();
+
+		static std::atomic<bool> enabled;
+		static std::mutex ringsMutex;
+		// Rings outlive their threads so events of finished workers still get exported
+		static std::vector<ThreadRing*> rings;
+};
+
+class ProfileScope
+{
+	public:
+		explicit ProfileScope(const char *name)
+		{
+			this->name = Profiler::IsEnabled() ? name : nullptr;
+			start = this->name ? Profiler::Now() : 0;
+		}
+
+		~ProfileScope()
+		{
+			if (name)
+				Profiler::Record(name, start, Profiler::Now());
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char *name;
+		uint64_t start;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef DISABLE_PROFILER
+	#define PROFILE_SCOPE(name)
+#else
+	#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
@@ -0,0 +1,170 @@
+#include "StartupReport.h"
+
+#include <algorithm>
+#include <sys/stat.h>
+
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/Profiler.h>
+
+using namespace std;
+
+std::vector<StartupReport::Phase> StartupReport::phases;
+std::vector<int> StartupReport::openPhases;
+std::atomic<uint64_t> StartupReport::bytesRead(0);
+std::atomic<uint64_t> StartupReport::objects[StartupReport::GL_OBJECT_TYPES];
+double StartupReport::budget = 0;
+double StartupReport::totalTime = 0;
+bool StartupReport::finished = false;
+
+namespace
+{
+	const char *objectNames[] = { "buffers", "vertex arrays", "textures", "shaders", "programs", "framebuffers",
+		"renderbuffers", "queries" };
+}
+
+StartupReport::Counters StartupReport::Snapshot()
+{
+	Counters counters;
+	counters.time = Profiler::Now();
+	counters.bytesRead = bytesRead.load(memory_order_relaxed);
+	for (int i = 0; i < GL_OBJECT_TYPES; i++)
+		counters.objects[i] = objects[i].load(memory_order_relaxed);
+	return counters;
+}
+
+void StartupReport::BeginPhase(const char *name)
+{
+	if (finished)
+		return;
+
+	Phase phase;
+	phase.name = name;
+	phase.parent = openPhases.empty() ? -1 : openPhases.back();
+	phase.start = Snapshot();
+	phase.total = Counters();
+	phase.children = Counters();
+
+	openPhases.push_back(static_cast<int>(phases.size()));
+	phases.push_back(phase);
+}
+
+void StartupReport::EndPhase()
+{
+	if (finished || openPhases.empty())
+		return;
+
+	Phase &phase = phases[openPhases.back()];
+	openPhases.pop_back();
+
+	Counters now = Snapshot();
+	phase.total.time = now.time - phase.start.time;
+	phase.total.bytesRead = now.bytesRead - phase.start.bytesRead;
+	for (int i = 0; i < GL_OBJECT_TYPES; i++)
+		phase.total.objects[i] = now.objects[i] - phase.start.objects[i];
+
+	if (phase.parent >= 0)
+	{
+		Counters &children = phases[phase.parent].children;
+		children.time += phase.total.time;
+		children.bytesRead += phase.total.bytesRead;
+		for (int i = 0; i < GL_OBJECT_TYPES; i++)
+			children.objects[i] += phase.total.objects[i];
+	}
+}
+
+void StartupReport::AddBytesRead(uint64_t bytes)
+{
+	bytesRead.fetch_add(bytes, memory_order_relaxed);
+}
+
+void StartupReport::AddFileRead(const std::string &file)
+{
+	struct stat fileInfo;
+	if (stat(file.c_str(), &fileInfo) == 0)
+		AddBytesRead(static_cast<uint64_t>(fileInfo.st_size));
+}
+
+void StartupReport::AddGLObjects(GLObjectType type, unsigned int count)
+{
+	objects[type].fetch_add(count, memory_order_relaxed);
+}
+
+void StartupReport::SetBudget(double seconds)
+{
+	budget = seconds;
+}
+
+double StartupReport::GetBudget()
+{
+	return budget;
+}
+
+void StartupReport::Finish()
+{
+	if (finished)
+		return;
+
+	while (!openPhases.empty())
+		EndPhase();
+
+	// The profiler clock starts with the process
+	totalTime = Profiler::Now() / 1e9;
+	finished = true;
+	Print();
+}
+
+bool StartupReport::IsFinished()
+{
+	return finished;
+}
+
+double StartupReport::GetTotalTime()
+{
+	return totalTime;
+}
+
+bool StartupReport::IsOverBudget()
+{
+	return finished && budget > 0 && totalTime > budget;
+}
+
+void StartupReport::Print()
+{
+	vector<int> order(phases.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = static_cast<int>(i);
+	sort(order.begin(), order.end(), [](int a, int b) {
+		return phases[a].total.time - phases[a].children.time > phases[b].total.time - phases[b].children.time;
+	});
+
+	string text = "=====================================================\n";
+	Log::AppendFormat(text, "Startup %.1f ms", totalTime * 1000);
+	if (budget > 0)
+		Log::AppendFormat(text, " (budget %.1f ms%s)", budget * 1000, IsOverBudget() ? ", OVER BUDGET" : "");
+	text += "\n  self ms  total ms   read KB  GL objs  phase\n";
+
+	for (auto index : order)
+	{
+		const Phase &phase = phases[index];
+		uint64_t selfObjects = 0;
+		for (int i = 0; i < GL_OBJECT_TYPES; i++)
+			selfObjects += phase.total.objects[i] - phase.children.objects[i];
+
+		// Nested phases are printed with their parents, "Game::Init > Shaders"
+		string path = phase.name;
+		for (int parent = phase.parent; parent >= 0; parent = phases[parent].parent)
+			path = string(phases[parent].name) + " > " + path;
+
+		Log::AppendFormat(text, "%9.2f %9.2f %9.1f %8llu  %s\n",
+			(phase.total.time - phase.children.time) / 1e6, phase.total.time / 1e6,
+			(phase.total.bytesRead - phase.children.bytesRead) / 1024.0,
+			static_cast<unsigned long long>(selfObjects), path.c_str());
+	}
+
+	text += "  GL objects:";
+	for (int i = 0; i < GL_OBJECT_TYPES; i++)
+		Log::AppendFormat(text, " %llu %s%s", static_cast<unsigned long long>(objects[i].load()), objectNames[i],
+			i + 1 < GL_OBJECT_TYPES ? "," : "\n");
+	Log::AppendFormat(text, "  Read from disk: %.1f KB\n", bytesRead.load() / 1024.0);
+	Log::Report(text);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ *	Startup breakdown: STARTUP_PHASE("name") times the enclosing block along with the bytes read from disk and the
+ *	OpenGL objects created while it ran. Phases nest, each one reports its self values (children excluded)
+ *	Counters are shared by all threads, so work of the asset loader threads lands in whichever phase is open
+ *	Finish() closes the report once the first frame with every asset uploaded is reached and prints it sorted by
+ *	self time; a run whose total exceeds the budget is flagged (Main turns it into a failing exit code)
+ */
+
+class StartupReport
+{
+	public:
+		enum GLObjectType
+		{
+			GL_OBJECT_BUFFER,
+			GL_OBJECT_VERTEX_ARRAY,
+			GL_OBJECT_TEXTURE,
+			GL_OBJECT_SHADER,
+			GL_OBJECT_PROGRAM,
+			GL_OBJECT_FRAMEBUFFER,
+			GL_OBJECT_RENDERBUFFER,
+			GL_OBJECT_QUERY,
+			GL_OBJECT_TYPES
+		};
+
+		// Phases are opened and closed on the main thread only, name must be a string literal
+		static void BeginPhase(const char *name);
+		static void EndPhase();
+
+		// Counters, callable from any thread
+		static void AddBytesRead(uint64_t bytes);
+		// Counts the size of a file read by a library that does its own I/O (Assimp, stb_image)
+		static void AddFileRead(const std::string &file);
+		static void AddGLObjects(GLObjectType type, unsigned int count = 1);
+
+		// Seconds, 0 disables the check
+		static void SetBudget(double seconds);
+		static double GetBudget();
+
+		static void Finish();
+		static bool IsFinished();
+		// Seconds from process start to Finish
+		static double GetTotalTime();
+		static bool IsOverBudget();
+
+	protected:
+		StartupReport() = delete;
+		~StartupReport() = delete;
+
+	private:
+		struct Counters
+		{
+			uint64_t time;
+			uint64_t bytesRead;
+			uint64_t objects[GL_OBJECT_TYPES];
+		};
+
+		struct Phase
+		{
+			const char *name;
+			int parent;
+			Counters start;
+			// Totals while the phase was open, then the part spent in child phases
+			Counters total;
+			Counters children;
+		};
+
+		static Counters Snapshot();
+		static void Print();
+
+		static std::vector<Phase> phases;
+		static std::vector<int> openPhases;
+		static std::atomic<uint64_t> bytesRead;
+		static std::atomic<uint64_t> objects[GL_OBJECT_TYPES];
+		static double budget;
+		static double totalTime;
+		static bool finished;
+};
+
+class StartupPhaseScope
+{
+	public:
+		explicit StartupPhaseScope(const char *name)
+		{
+			StartupReport::BeginPhase(name);
+		}
+
+		~StartupPhaseScope()
+		{
+			StartupReport::EndPhase();
+		}
+
+		StartupPhaseScope(const StartupPhaseScope&) = delete;
+		StartupPhaseScope& operator=(const StartupPhaseScope&) = delete;
+};
+
+#define STARTUP_PHASE_CONCAT_IMPL(a, b) a##b
+#define STARTUP_PHASE_CONCAT(a, b) STARTUP_PHASE_CONCAT_IMPL(a, b)
+#define STARTUP_PHASE(name) StartupPhaseScope STARTUP_PHASE_CONCAT(startupPhase, __LINE__)(name)
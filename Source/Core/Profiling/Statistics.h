@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+/*
+ *	Helpers shared by the reports, so that they agree on the same data
+ */
+
+// Nearest-rank percentile (0-100): the smallest value with at least percentile % of the values at or below it
+// values must be sorted, returns 0 when there are none
+inline double Percentile(const std::vector<double> &values, double percentile)
+{
+	if (values.empty())
+		return 0;
+
+	double rank = std::ceil(percentile / 100.0 * values.size());
+	if (rank < 1)
+		return values.front();
+	if (rank >= values.size())
+		return values.back();
+	return values[static_cast<size_t>(rank) - 1];
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+/*
+ *	Unbounded lock-free multi-producer / single-consumer queue
+ *	Push() may be called from any thread, TryPop() only from the consumer thread
+ */
+
+template <typename T>
+class MPSCQueue
+{
+	public:
+		MPSCQueue()
+		{
+			Node *stub = new Node();
+			head.store(stub, std::memory_order_relaxed);
+			tail = stub;
+		}
+
+		~MPSCQueue()
+		{
+			T value;
+			while (TryPop(value));
+			delete tail;
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		void Push(T value)
+		{
+			Node *node = new Node(std::move(value));
+			Node *prev = head.exchange(node, std::memory_order_acq_rel);
+			prev->next.store(node, std::memory_order_release);
+		}
+
+		bool TryPop(T &value)
+		{
+			Node *next = tail->next.load(std::memory_order_acquire);
+			if (next == nullptr)
+				return false;
+
+			// next becomes the new stub, its value is moved out
+			value = std::move(next->value);
+			delete tail;
+			tail = next;
+			return true;
+		}
+
+	private:
+		struct Node
+		{
+			Node() : next(nullptr) {}
+			Node(T &&value) : value(std::move(value)), next(nullptr) {}
+
+			T value;
+			std::atomic<Node*> next;
+		};
+
+		// Producers and consumer work on different ends, keep them on separate cache lines
+		alignas(64) std::atomic<Node*> head;
+		alignas(64) Node *tail;
+};
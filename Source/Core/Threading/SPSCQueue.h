@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/*
+ *	Bounded lock-free single-producer / single-consumer ring
+ *	TryPush() only from the producer thread, TryPop() only from the consumer thread
+ *	Capacity must be a power of two, TryPush() fails instead of blocking when the ring is full
+ */
+
+template <typename T, size_t Capacity>
+class SPSCQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+	public:
+		SPSCQueue() : head(0), tail(0) {}
+
+		SPSCQueue(const SPSCQueue&) = delete;
+		SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+		bool TryPush(T value)
+		{
+			size_t position = head.load(std::memory_order_relaxed);
+			if (position - tail.load(std::memory_order_acquire) == Capacity)
+				return false;
+
+			slots[position & (Capacity - 1)] = std::move(value);
+			head.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool TryPop(T &value)
+		{
+			size_t position = tail.load(std::memory_order_relaxed);
+			if (position == head.load(std::memory_order_acquire))
+				return false;
+
+			value = std::move(slots[position & (Capacity - 1)]);
+			tail.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		T slots[Capacity];
+
+		// Producer and consumer work on different ends, keep them on separate cache lines
+		alignas(64) std::atomic<size_t> head;
+		alignas(64) std::atomic<size_t> tail;
+};
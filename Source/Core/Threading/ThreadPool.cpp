@@ -0,0 +1,93 @@
+#include "ThreadPool.h"
+
+#include <Core/Profiling/Profiler.h>
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned int nrThreads)
+{
+	busyWorkers = 0;
+	stopping = false;
+
+	if (nrThreads == 0) {
+		unsigned int cores = thread::hardware_concurrency();
+		nrThreads = cores > 1 ? cores - 1 : 1;
+	}
+
+	workers.reserve(nrThreads);
+	for (unsigned int i = 0; i < nrThreads; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(jobsMutex);
+		stopping = true;
+		jobs.clear();
+	}
+	jobAvailable.notify_all();
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::Enqueue(function<void()> job)
+{
+	{
+		lock_guard<mutex> lock(jobsMutex);
+		jobs.push_back(move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+void ThreadPool::WaitIdle()
+{
+	unique_lock<mutex> lock(jobsMutex);
+	jobsDone.wait(lock, [this]() { return jobs.empty() && busyWorkers == 0; });
+}
+
+unsigned int ThreadPool::GetThreadCount() const
+{
+	return static_cast<unsigned int>(workers.size());
+}
+
+unsigned int ThreadPool::GetPendingJobs() const
+{
+	lock_guard<mutex> lock(jobsMutex);
+	return static_cast<unsigned int>(jobs.size()) + busyWorkers;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	Profiler::SetThreadName("Worker");
+
+	while (true)
+	{
+		function<void()> job;
+		{
+			unique_lock<mutex> lock(jobsMutex);
+			jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (stopping)
+				return;
+
+			job = move(jobs.front());
+			jobs.pop_front();
+			busyWorkers++;
+		}
+
+		{
+			PROFILE_SCOPE("Job");
+			job();
+		}
+
+		{
+			lock_guard<mutex> lock(jobsMutex);
+			busyWorkers--;
+			if (jobs.empty() && busyWorkers == 0)
+				jobsDone.notify_all();
+		}
+	}
+}
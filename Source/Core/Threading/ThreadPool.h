@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ *	Fixed set of worker threads consuming jobs in FIFO order
+ *	Jobs must not touch the OpenGL context, hand results back to the render thread instead
+ */
+
+class ThreadPool
+{
+	public:
+		// nrThreads = 0 picks one thread per hardware core, minus the render thread
+		ThreadPool(unsigned int nrThreads = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void Enqueue(std::function<void()> job);
+
+		// Blocks until the job queue is empty and no worker is busy
+		void WaitIdle();
+
+		unsigned int GetThreadCount() const;
+		unsigned int GetPendingJobs() const;
+
+	private:
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> jobs;
+
+		mutable std::mutex jobsMutex;
+		std::condition_variable jobAvailable;
+		std::condition_variable jobsDone;
+
+		unsigned int busyWorkers;
+		bool stopping;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+
+/*
+ *	Lock-free triple buffer handing the latest value from one writer thread to one reader thread
+ *	The writer fills GetWriteBuffer() and calls Publish(), the reader gets the newest published value from
+ *	Acquire() and keeps it until its next Acquire(); neither side ever waits for the other
+ *	Values are reused, the writer has to overwrite everything it publishes
+ */
+
+template <typename T>
+class TripleBuffer
+{
+	public:
+		TripleBuffer() : shared(1), writeIndex(0), readIndex(2) {}
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		// Writer side
+		T& GetWriteBuffer()
+		{
+			return buffers[writeIndex];
+		}
+
+		void Publish()
+		{
+			writeIndex = shared.exchange(writeIndex | DIRTY, std::memory_order_acq_rel) & INDEX;
+		}
+
+		// Reader side, returns the previous value again when nothing new was published
+		const T& Acquire()
+		{
+			if (shared.load(std::memory_order_relaxed) & DIRTY)
+				readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & INDEX;
+			return buffers[readIndex];
+		}
+
+	private:
+		static const unsigned int INDEX = 3;
+		static const unsigned int DIRTY = 4;
+
+		T buffers[3];
+
+		// Index of the spare buffer, DIRTY while it holds a value the reader has not seen
+		alignas(64) std::atomic<unsigned int> shared;
+		alignas(64) unsigned int writeIndex;
+		alignas(64) unsigned int readIndex;
+};
@@ -0,0 +1,238 @@
+#include "HeadlessContext.h"
+
+#include <cstring>
+
+#include <Core/Logging/Log.h>
+
+#ifdef __linux__
+	#include <dlfcn.h>
+	#include <EGL/egl.h>
+	#include <EGL/eglext.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+
+namespace
+{
+	// Entry points resolved from libEGL at runtime
+	struct EGLFunctions
+	{
+		PFNEGLGETPROCADDRESSPROC GetProcAddress;
+		PFNEGLQUERYSTRINGPROC QueryString;
+		PFNEGLGETDISPLAYPROC GetDisplay;
+		PFNEGLGETPLATFORMDISPLAYEXTPROC GetPlatformDisplayEXT;
+		PFNEGLINITIALIZEPROC Initialize;
+		PFNEGLTERMINATEPROC Terminate;
+		PFNEGLBINDAPIPROC BindAPI;
+		PFNEGLCHOOSECONFIGPROC ChooseConfig;
+		PFNEGLCREATECONTEXTPROC CreateContext;
+		PFNEGLDESTROYCONTEXTPROC DestroyContext;
+		PFNEGLCREATEPBUFFERSURFACEPROC CreatePbufferSurface;
+		PFNEGLDESTROYSURFACEPROC DestroySurface;
+		PFNEGLMAKECURRENTPROC MakeCurrent;
+	} egl;
+
+	bool HasExtension(const char *extensions, const char *name)
+	{
+		if (!extensions)
+			return false;
+
+		size_t length = strlen(name);
+		for (const char *start = strstr(extensions, name); start; start = strstr(start + length, name)) {
+			bool wordStart = start == extensions || start[-1] == ' ';
+			bool wordEnd = start[length] == ' ' || start[length] == '\0';
+			if (wordStart && wordEnd)
+				return true;
+		}
+		return false;
+	}
+
+	template <typename T>
+	bool Resolve(void *library, T &function, const char *name)
+	{
+		function = reinterpret_cast<T>(dlsym(library, name));
+		return function != nullptr;
+	}
+}
+
+#endif
+
+HeadlessContext::HeadlessContext()
+{
+	library = nullptr;
+	display = nullptr;
+	context = nullptr;
+	surface = nullptr;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+bool HeadlessContext::IsSupported()
+{
+	#ifdef __linux__
+	return true;
+	#else
+	return false;
+	#endif
+}
+
+bool HeadlessContext::IsCreated() const
+{
+	return context != nullptr;
+}
+
+bool HeadlessContext::Create()
+{
+	#ifdef __linux__
+	Destroy();
+
+	library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+	if (!library) {
+		Log::Warn("[Headless] libEGL.so.1 not found");
+		return false;
+	}
+
+	bool resolved = Resolve(library, egl.GetProcAddress, "eglGetProcAddress")
+		&& Resolve(library, egl.QueryString, "eglQueryString")
+		&& Resolve(library, egl.GetDisplay, "eglGetDisplay")
+		&& Resolve(library, egl.Initialize, "eglInitialize")
+		&& Resolve(library, egl.Terminate, "eglTerminate")
+		&& Resolve(library, egl.BindAPI, "eglBindAPI")
+		&& Resolve(library, egl.ChooseConfig, "eglChooseConfig")
+		&& Resolve(library, egl.CreateContext, "eglCreateContext")
+		&& Resolve(library, egl.DestroyContext, "eglDestroyContext")
+		&& Resolve(library, egl.CreatePbufferSurface, "eglCreatePbufferSurface")
+		&& Resolve(library, egl.DestroySurface, "eglDestroySurface")
+		&& Resolve(library, egl.MakeCurrent, "eglMakeCurrent");
+	if (!resolved) {
+		Log::Warn("[Headless] libEGL is missing core entry points");
+		Destroy();
+		return false;
+	}
+
+	// The surfaceless platform needs neither X11 nor Wayland nor a DRM device
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+	const char *clientExtensions = egl.QueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	egl.GetPlatformDisplayEXT = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(egl.GetProcAddress("eglGetPlatformDisplayEXT"));
+	if (egl.GetPlatformDisplayEXT && HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+		eglDisplay = egl.GetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (eglDisplay == EGL_NO_DISPLAY)
+		eglDisplay = egl.GetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major = 0, minor = 0;
+	if (eglDisplay == EGL_NO_DISPLAY || !egl.Initialize(eglDisplay, &major, &minor)) {
+		Log::Warn("[Headless] No EGL display");
+		Destroy();
+		return false;
+	}
+	display = eglDisplay;
+
+	if (!egl.BindAPI(EGL_OPENGL_API)) {
+		Log::Warn("[Headless] EGL " + to_string(major) + "." + to_string(minor) +
+			" cannot create desktop OpenGL contexts");
+		Destroy();
+		return false;
+	}
+
+	// Without surfaceless contexts a tiny pbuffer stands in for the default framebuffer, it is never drawn to
+	const char *displayExtensions = egl.QueryString(eglDisplay, EGL_EXTENSIONS);
+	bool surfaceless = HasExtension(displayExtensions, "EGL_KHR_surfaceless_context");
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint nrConfigs = 0;
+	if (!egl.ChooseConfig(eglDisplay, configAttributes, &config, 1, &nrConfigs) || nrConfigs == 0) {
+		Log::Warn("[Headless] No EGL config for desktop OpenGL");
+		Destroy();
+		return false;
+	}
+
+	// Same version and profile WindowObject asks GLFW for
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+		EGL_NONE
+	};
+	bool versioned = (major > 1 || minor >= 5) || HasExtension(displayExtensions, "EGL_KHR_create_context");
+	context = egl.CreateContext(eglDisplay, config, EGL_NO_CONTEXT, versioned ? contextAttributes : nullptr);
+	if (context == EGL_NO_CONTEXT) {
+		context = nullptr;
+		Log::Warn("[Headless] Could not create an OpenGL 3.3 context");
+		Destroy();
+		return false;
+	}
+
+	if (!surfaceless)
+	{
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surface = egl.CreatePbufferSurface(eglDisplay, config, pbufferAttributes);
+		if (surface == EGL_NO_SURFACE) {
+			surface = nullptr;
+			Log::Warn("[Headless] Could not create a pbuffer surface");
+			Destroy();
+			return false;
+		}
+	}
+
+	if (!MakeCurrent()) {
+		Log::Warn("[Headless] Could not make the context current");
+		Destroy();
+		return false;
+	}
+
+	Log::Info("[Headless] EGL " + to_string(major) + "." + to_string(minor) + (surfaceless ? " surfaceless" : " pbuffer") +
+		" context");
+	return true;
+	#else
+	return false;
+	#endif
+}
+
+void HeadlessContext::Destroy()
+{
+	#ifdef __linux__
+	if (display)
+	{
+		egl.MakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (surface)
+			egl.DestroySurface(display, surface);
+		if (context)
+			egl.DestroyContext(display, context);
+		egl.Terminate(display);
+	}
+
+	if (library)
+		dlclose(library);
+	#endif
+
+	library = nullptr;
+	display = nullptr;
+	context = nullptr;
+	surface = nullptr;
+}
+
+bool HeadlessContext::MakeCurrent() const
+{
+	#ifdef __linux__
+	if (!context)
+		return false;
+
+	EGLSurface eglSurface = surface ? surface : EGL_NO_SURFACE;
+	return egl.MakeCurrent(display, eglSurface, eglSurface, context) == EGL_TRUE;
+	#else
+	return false;
+	#endif
+}
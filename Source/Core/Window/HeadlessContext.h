@@ -0,0 +1,33 @@
+#pragma once
+
+/*
+ *	OpenGL 3.3 compatibility context without a window or display, created through EGL on the surfaceless platform
+ *	(Mesa llvmpipe on servers and CI). libEGL is loaded at runtime, so a normal windowed build never depends on it
+ *	There is no default framebuffer to draw to, WindowObject renders into its offscreen framebuffer instead
+ */
+
+class HeadlessContext
+{
+	public:
+		HeadlessContext();
+		~HeadlessContext();
+
+		HeadlessContext(const HeadlessContext&) = delete;
+		HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+		// Creates the context and makes it current, returns false when EGL is missing or refuses
+		bool Create();
+		void Destroy();
+
+		bool MakeCurrent() const;
+		bool IsCreated() const;
+
+		// Always false on platforms without EGL support
+		static bool IsSupported();
+
+	private:
+		void *library;
+		void *display;
+		void *context;
+		void *surface;
+};
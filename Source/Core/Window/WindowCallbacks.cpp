@@ -1,31 +1,37 @@
 #include "WindowCallbacks.h"
 
-#include <iostream>
-
 #include <Core/Engine.h>
 #include <Core/Window/WindowObject.h>
 
 #include <include/gl.h>
 
-using namespace std;
+void WindowCallbacks::RecordSample(InputSample::Type type, int code, int action, int mods, double x, double y)
+{
+	InputSample sample = { type, Engine::GetElapsedTime(), code, action, mods, x, y };
+	Engine::GetWindow()->RecordInputSample(sample);
+}
 
 void WindowCallbacks::KeyCallback(GLFWwindow *W, int key, int scanCode, int action, int mods)
 {
+	RecordSample(InputSample::Type::KEY, key, action, mods);
 	Engine::GetWindow()->KeyCallback(key, scanCode, action, mods);
 }
 
 void WindowCallbacks::CursorMove(GLFWwindow *W, double posX, double posY)
 {
+	RecordSample(InputSample::Type::MOUSE_MOVE, 0, 0, 0, posX, posY);
 	Engine::GetWindow()->MouseMove((int)posX, (int)posY);
 }
 
 void WindowCallbacks::MouseClick(GLFWwindow *W, int button, int action, int mods)
 {
+	RecordSample(InputSample::Type::MOUSE_BUTTON, button, action, mods);
 	Engine::GetWindow()->MouseButtonCallback(button, action, mods);
 }
 
 void WindowCallbacks::MouseScroll(GLFWwindow * W, double offsetX, double offsetY)
 {
+	RecordSample(InputSample::Type::MOUSE_SCROLL, 0, 0, 0, offsetX, offsetY);
 	Engine::GetWindow()->MouseScroll(offsetX, offsetY);
 }
 
@@ -41,5 +47,5 @@ void WindowCallbacks::OnResize(GLFWwindow *W, int width, int height)
 
 void WindowCallbacks::OnError(int error, const char * description)
 {
-	cout << "[GLFW ERROR]\t" << error << "\t" << description << endl;
+	Log::Error("[GLFW ERROR]", { { "code", error }, { "description", description } });
 }
\ No newline at end of file
@@ -8,6 +8,9 @@ class WindowCallbacks
 	private:
 		WindowCallbacks() = delete;
 
+		// Stamped when GLFW delivers the event, not when the frame gets to it
+		static void RecordSample(InputSample::Type type, int code, int action, int mods, double x = 0, double y = 0);
+
 	public:
 		// Window events
 		static void OnClose(GLFWwindow *W);
@@ -1,14 +1,18 @@
 #include "WindowObject.h"
 
-#include <iostream>
+#include <chrono>
+#include <thread>
 #include <include/gl.h>
 #include <include/utils.h>
 
 #include "../Engine.h"
+#include "HeadlessContext.h"
 #include "WindowCallbacks.h"
 #include "InputController.h"
+#include "../Profiling/StartupReport.h"
 
 #include <include/gl.h>
+#include <stb/stb_image_write.h>
 
 using namespace std;
 
@@ -25,21 +29,38 @@ WindowProperties::WindowProperties()
 	visible = true;
 	hideOnClose = false;
 	vSync = true;
+	headless = false;
+	frameLimit = 0;
 }
 
 WindowObject::WindowObject(WindowProperties properties)
 	: props(properties)
 {
 	window = nullptr;
+	headlessContext = nullptr;
+	offscreenFBO = 0;
+	offscreenColor = 0;
+	offscreenDepth = 0;
+	presentedFrames = 0;
+	closeRequested = false;
 
 	resizeEvent = false;
 	scrollEvent = false;
+	inputEvent = false;
 	mouseMoveEvent = false;
+	mouseMoveTime = 0;
+	inputSampling = 0;
 
 	frameID = 0;
 	deltaFrameTime = 0;
 	props.aspectRatio = float(props.resolution.x) / props.resolution.y;
 
+	if (props.headless) {
+		props.visible = false;
+		props.fullScreen = false;
+		props.vSync = false;
+	}
+
 	// Set context version
 	glfwWindowHint(GLFW_VISIBLE, props.visible);
 
@@ -48,7 +69,10 @@ WindowObject::WindowObject(WindowProperties properties)
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
 
 	// Init OpenGL Window
-	props.fullScreen ? FullScreen() : WindowMode();
+	if (props.headless)
+		HeadlessMode();
+	else
+		props.fullScreen ? FullScreen() : WindowMode();
 
 	SetVSync(props.vSync);
 
@@ -66,11 +90,21 @@ WindowObject::WindowObject(WindowProperties properties)
 
 WindowObject::~WindowObject()
 {
+	if (offscreenFBO) {
+		glDeleteFramebuffers(1, &offscreenFBO);
+		glDeleteRenderbuffers(1, &offscreenColor);
+		glDeleteRenderbuffers(1, &offscreenDepth);
+	}
+	SAFE_FREE(headlessContext);
 	glfwDestroyWindow(window);
 }
 
 void WindowObject::Show()
 {
+	// A headless window stays hidden, there is nothing to show
+	if (props.headless)
+		return;
+
 	props.visible = true;
 	glfwShowWindow(window);
 	MakeCurrentContext();
@@ -79,13 +113,15 @@ void WindowObject::Show()
 void WindowObject::Hide()
 {
 	props.visible = false;
-	glfwHideWindow(window);
+	if (window)
+		glfwHideWindow(window);
 }
 
 void WindowObject::SetVSync(bool state)
 {
 	props.vSync = state;
-	glfwSwapInterval(state);
+	if (window)
+		glfwSwapInterval(state);
 }
 
 bool WindowObject::ToggleVSync()
@@ -96,41 +132,52 @@ bool WindowObject::ToggleVSync()
 
 void WindowObject::Close()
 {
-	props.hideOnClose ? Hide() : glfwSetWindowShouldClose(window, 1);
+	if (props.headless || !window)
+		closeRequested = true;
+	else
+		props.hideOnClose ? Hide() : glfwSetWindowShouldClose(window, 1);
 }
 
 int WindowObject::ShouldClose() const
 {
-	return glfwWindowShouldClose(window);
+	if (closeRequested)
+		return 1;
+	return window ? glfwWindowShouldClose(window) : 0;
 }
 
 void WindowObject::ShowPointer()
 {
 	hiddenPointer = false;
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+	if (window)
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 }
 
 void WindowObject::HidePointer()
 {
 	hiddenPointer = true;
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+	if (window)
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
 }
 
 void WindowObject::DisablePointer()
 {
 	hiddenPointer = true;
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	if (window)
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 }
 
 void WindowObject::SetWindowPosition(glm::ivec2 position)
 {
 	props.position = position;
-	glfwSetWindowPos(window, position.x, position.y);
+	if (window)
+		glfwSetWindowPos(window, position.x, position.y);
 }
 
 void WindowObject::CenterWindow()
 {
 	props.centered = true;
+	if (!window)
+		return;
 
 	GLFWmonitor *monitor = glfwGetPrimaryMonitor();
 	const GLFWvidmode *videoDisplay = glfwGetVideoMode(monitor);
@@ -143,19 +190,42 @@ void WindowObject::CenterPointer()
 {
 	props.cursorPos.x = props.resolution.x / 2;
 	props.cursorPos.y = props.resolution.y / 2;
-	glfwSetCursorPos(window, props.cursorPos.x, props.cursorPos.y);
+	if (window)
+		glfwSetCursorPos(window, props.cursorPos.x, props.cursorPos.y);
 }
 
 void WindowObject::SetPointerPosition(int mousePosX, int mousePosY)
 {
 	props.cursorPos.x = mousePosX;
 	props.cursorPos.y = mousePosY;
-	glfwSetCursorPos(window, mousePosX, mousePosY);
+	if (window)
+		glfwSetCursorPos(window, mousePosX, mousePosY);
 }
 
 void WindowObject::PollEvents() const
 {
-	glfwPollEvents();
+	if (window)
+		glfwPollEvents();
+}
+
+void WindowObject::WaitEvents(double timeout) const
+{
+	if (!window) {
+		if (timeout > 0)
+			this_thread::sleep_for(chrono::duration<double>(timeout));
+		return;
+	}
+
+	if (timeout < 0)
+		glfwWaitEvents();
+	else
+		glfwWaitEventsTimeout(timeout);
+}
+
+void WindowObject::WakeUp() const
+{
+	if (window)
+		glfwPostEmptyEvent();
 }
 
 void WindowObject::ComputeFrameTime()
@@ -197,6 +267,104 @@ void WindowObject::WindowMode()
 	resizeEvent = false;
 }
 
+void WindowObject::HeadlessMode()
+{
+	// EGL needs no display at all, a hidden GLFW window is the fallback where EGL is missing
+	headlessContext = new HeadlessContext();
+	if (!headlessContext->Create())
+	{
+		SAFE_FREE(headlessContext);
+		window = glfwCreateWindow(props.resolution.x, props.resolution.y, props.name.c_str(), NULL, NULL);
+		if (!window)
+			Log::Error("[Headless] Neither an EGL context nor a hidden window could be created");
+		assert(window != nullptr);
+		glfwMakeContextCurrent(window);
+		Log::Info("[Headless] Hidden window context");
+	}
+
+	// The offscreen framebuffer is created once the GL entry points are loaded, see InitOffscreenFramebuffer
+	props.aspectRatio = float(props.resolution.x) / props.resolution.y;
+	resizeEvent = false;
+}
+
+void WindowObject::InitOffscreenFramebuffer()
+{
+	if (!props.headless || offscreenFBO)
+		return;
+
+	glGenFramebuffers(1, &offscreenFBO);
+	glGenRenderbuffers(1, &offscreenColor);
+	glGenRenderbuffers(1, &offscreenDepth);
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_FRAMEBUFFER);
+	StartupReport::AddGLObjects(StartupReport::GL_OBJECT_RENDERBUFFER, 2);
+	ResizeOffscreenFramebuffer();
+
+	BindFramebuffer();
+	glViewport(0, 0, props.resolution.x, props.resolution.y);
+}
+
+void WindowObject::ResizeOffscreenFramebuffer()
+{
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreenColor);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, props.resolution.x, props.resolution.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, props.resolution.x, props.resolution.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreenFBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColor);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreenDepth);
+
+	// Reads (screenshots) and draws both go to the color attachment
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		Log::Error("[Headless] Offscreen framebuffer incomplete");
+	CheckOpenGLError();
+}
+
+GLuint WindowObject::GetFramebuffer() const
+{
+	return offscreenFBO;
+}
+
+void WindowObject::BindFramebuffer() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreenFBO);
+}
+
+bool WindowObject::IsHeadless() const
+{
+	return props.headless;
+}
+
+bool WindowObject::SaveScreenshot(const std::string &file) const
+{
+	int width = props.resolution.x;
+	int height = props.resolution.y;
+	size_t stride = static_cast<size_t>(width) * 4;
+	vector<unsigned char> pixels(stride * height);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, offscreenFBO);
+	if (!offscreenFBO)
+		glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	// OpenGL rows start at the bottom of the image
+	vector<unsigned char> image(pixels.size());
+	for (int y = 0; y < height; y++)
+		memcpy(&image[y * stride], &pixels[(height - 1 - y) * stride], stride);
+
+	bool saved = stbi_write_png(file.c_str(), width, height, 4, image.data(), static_cast<int>(stride)) != 0;
+	if (saved)
+		Log::Info("[Screenshot] Saved " + file);
+	else
+		Log::Error("[Screenshot] Could not write " + file);
+	return saved;
+}
+
 void WindowObject::SubscribeToEvents(InputController * IC)
 {
 	observers.push_back(IC);
@@ -209,6 +377,9 @@ void WindowObject::UnsubscribeFromEvents(InputController * IC)
 
 void WindowObject::SetWindowCallbacks()
 {
+	if (!window)
+		return;
+
 	glfwSetWindowCloseCallback(window, WindowCallbacks::OnClose);
 	glfwSetWindowSizeCallback(window, WindowCallbacks::OnResize);
 	glfwSetKeyCallback(window, WindowCallbacks::KeyCallback);
@@ -286,6 +457,11 @@ void WindowObject::UpdateObservers()
 {
 	ComputeFrameTime();
 
+	inputEvent = resizeEvent || mouseMoveEvent || mouseButtonAction || mouseButtonStates || scrollEvent ||
+		registeredKeyEvents;
+	for (int key = 0; key < 384 && !inputEvent; key++)
+		inputEvent = keyStates[key];
+
 	// Signal window resize
 	if (resizeEvent)
 	{
@@ -349,20 +525,58 @@ void WindowObject::UpdateObservers()
 	mouseButtonAction = 0;
 }
 
+bool WindowObject::HadInput() const
+{
+	return inputEvent;
+}
+
+double WindowObject::GetMouseMoveTime() const
+{
+	return mouseMoveTime;
+}
+
+void WindowObject::SetInputSampling(unsigned int types)
+{
+	inputSampling = types;
+}
+
+bool WindowObject::PopInputSample(InputSample &sample)
+{
+	return inputSamples.TryPop(sample);
+}
+
+void WindowObject::RecordInputSample(const InputSample &sample)
+{
+	// Moves are merged until the next UpdateObservers, the first one dates the merged move
+	if (sample.type == InputSample::Type::MOUSE_MOVE && !mouseMoveEvent)
+		mouseMoveTime = sample.time;
+
+	if (inputSampling & InputSample::Mask(sample.type))
+		inputSamples.TryPush(sample);
+}
+
 void WindowObject::MakeCurrentContext() const
 {
-	glfwMakeContextCurrent(window);
+	if (headlessContext)
+		headlessContext->MakeCurrent();
+	else
+		glfwMakeContextCurrent(window);
 	CheckOpenGLError();
 }
 
 void WindowObject::SetSize(int width, int height)
 {
-	glfwSetWindowSize(window, width, height);
+	// Headless windows are only as big as their offscreen framebuffer
+	if (window && !props.headless)
+		glfwSetWindowSize(window, width, height);
 	glViewport(0, 0, width, height);
 
 	props.resolution = glm::ivec2(width, height);
 	props.aspectRatio = float(width) / height;
 	resizeEvent = true;
+
+	if (offscreenFBO)
+		ResizeOffscreenFramebuffer();
 }
 
 glm::ivec2 WindowObject::GetResolution() const
@@ -370,8 +584,26 @@ glm::ivec2 WindowObject::GetResolution() const
 	return props.resolution;
 }
 
-void WindowObject::SwapBuffers() const
+void WindowObject::SetTitle(const std::string &title)
 {
-	glfwSwapBuffers(window);
+	if (window)
+		glfwSetWindowTitle(window, title.c_str());
+}
+
+void WindowObject::SwapBuffers()
+{
+	presentedFrames++;
+	bool lastFrame = props.frameLimit && presentedFrames >= props.frameLimit;
+	if (lastFrame && !props.screenshotFile.empty())
+		SaveScreenshot(props.screenshotFile);
+
+	// Nothing is presented headless, the flush keeps the GPU from falling behind
+	if (props.headless)
+		glFlush();
+	else
+		glfwSwapBuffers(window);
 	CheckOpenGLError();
+
+	if (lastFrame)
+		closeRequested = true;
 }
@@ -5,6 +5,10 @@
 #include <include/gl.h>
 #include <include/glm.h>
 
+#include <Core/Threading/SPSCQueue.h>
+
+class HeadlessContext;
+
 class WindowProperties
 {
 	public:
@@ -22,6 +26,43 @@ class WindowProperties
 		bool centered;
 		bool hideOnClose;
 		bool vSync;
+
+		// No visible window: EGL context (or hidden window) rendering into an offscreen framebuffer of size resolution
+		bool headless;
+		// Closes the window after this many frames, 0 runs until Close()
+		unsigned int frameLimit;
+		// PNG written from the last frame when frameLimit is reached
+		std::string screenshotFile;
+};
+
+/*
+ *	Input callback as it arrived from GLFW, stamped with Engine::GetElapsedTime()
+ */
+
+struct InputSample
+{
+	enum class Type
+	{
+		KEY,
+		MOUSE_BUTTON,
+		MOUSE_MOVE,
+		MOUSE_SCROLL
+	};
+
+	// Bit of type in a SetInputSampling mask
+	static unsigned int Mask(Type type)
+	{
+		return 1u << static_cast<unsigned int>(type);
+	}
+
+	Type type;
+	double time;
+	// Key or mouse button, GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+	int code;
+	int action;
+	int mods;
+	// Cursor position or scroll offset
+	double x, y;
 };
 
 /*
@@ -51,7 +92,7 @@ class WindowObject
 		void SetWindowPosition(glm::ivec2 position);
 		void CenterWindow();
 
-		void SwapBuffers() const;
+		void SwapBuffers();
 		void SetVSync(bool state);
 		bool ToggleVSync();
 
@@ -60,12 +101,28 @@ class WindowObject
 		// Window Information
 		void SetSize(int width, int height);
 		glm::ivec2 GetResolution() const;
+		// props.name is left untouched so the original title can be restored
+		void SetTitle(const std::string &title);
 
 		// OpenGL State
 		GLFWwindow* GetGLFWWindow() const;
+
+		// Headless mode: creates the offscreen framebuffer, needs the GL entry points (call after glewInit)
+		void InitOffscreenFramebuffer();
+		// Framebuffer standing in for the default one: the offscreen target when headless, 0 otherwise
+		GLuint GetFramebuffer() const;
+		void BindFramebuffer() const;
+		bool IsHeadless() const;
+
+		// Reads back what was drawn to the current frame so far
+		bool SaveScreenshot(const std::string &file) const;
 	
 		// Window Event
 		void PollEvents() const;
+		// Sleeps until an event arrives or timeout seconds pass (a negative timeout waits for an event)
+		void WaitEvents(double timeout) const;
+		// Ends a WaitEvents early, callable from any thread
+		void WakeUp() const;
 
 		// Get Input State
 		bool KeyHold(int keyCode) const;
@@ -75,6 +132,18 @@ class WindowObject
 
 		// Update event listeners (key press / mouse move / window events)
 		void UpdateObservers();
+		// The last UpdateObservers dispatched an event or a key / mouse button is held down
+		bool HadInput() const;
+		// Time of the first cursor callback merged into the mouse move being dispatched
+		double GetMouseMoveTime() const;
+
+		// Timestamped copy of every input callback, read by a single consumer on any thread, e.g. a simulation
+		// thread that needs the exact time of a press instead of the frame that saw it
+		// Only the types in the mask (InputSample::Mask, 0 records nothing) are recorded: cursor moves arrive far more
+		// often than anything else and would fill the queue for a consumer that never reads them
+		// The oldest samples are kept when the consumer falls behind
+		void SetInputSampling(unsigned int types);
+		bool PopInputSample(InputSample &sample);
 
 	protected:
 		// Frame time
@@ -83,6 +152,8 @@ class WindowObject
 		// Window Creation
 		void FullScreen();
 		void WindowMode();
+		void HeadlessMode();
+		void ResizeOffscreenFramebuffer();
 
 		// Input Processing
 		void KeyCallback(int key, int scanCode, int action, int mods);
@@ -90,6 +161,9 @@ class WindowObject
 		void MouseMove(int posX, int posY);
 		void MouseScroll(double offsetX, double offsetY);
 
+		// Called from the GLFW callbacks, before the event is buffered for UpdateObservers
+		void RecordInputSample(const InputSample &sample);
+
 		// Subscribe to receive input events
 		void SubscribeToEvents(InputController * IC);
 		void UnsubscribeFromEvents(InputController * IC);
@@ -105,6 +179,16 @@ class WindowObject
 		void *openglHandle;
 		void *nativeRenderingContext;
 
+	private:
+		// Headless mode, the context is null when a hidden GLFW window provides it
+		HeadlessContext *headlessContext;
+		GLuint offscreenFBO;
+		GLuint offscreenColor;
+		GLuint offscreenDepth;
+
+		unsigned int presentedFrames;
+		bool closeRequested;
+
 	private:
 		// Frame Time
 		unsigned int frameID;
@@ -114,6 +198,7 @@ class WindowObject
 		// Window state and events
 		bool hiddenPointer;
 		bool resizeEvent;
+		bool inputEvent;
 
 		// Mouse button callback
 		int mouseButtonCallback;			// Bit field for button callback
@@ -122,6 +207,7 @@ class WindowObject
 
 		// Mouse move event
 		bool mouseMoveEvent;
+		double mouseMoveTime;
 		int mouseDeltaX;
 		int mouseDeltaY;
 
@@ -143,4 +229,7 @@ class WindowObject
 
 		// Input Observers
 		std::list<InputController*> observers;
+
+		unsigned int inputSampling;
+		SPSCQueue<InputSample, 1024> inputSamples;
 };
\ No newline at end of file
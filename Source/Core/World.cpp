@@ -1,14 +1,41 @@
 #include "World.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
 #include <Core/Engine.h>
+#include <Core/GPU/ShaderCache.h>
+#include <Core/Profiling/GpuProfiler.h>
+#include <Core/Profiling/Profiler.h>
 #include <Component/CameraInput.h>
 #include <Component/Transform/Transform.h>
 
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+	#include <mmsystem.h>
+	#pragma comment(lib, "winmm.lib")
+#endif
+
 World::World()
 {
 	previousTime = 0;
 	elapsedTime = 0;
 	deltaTime = 0;
+	tickTime = 1.0 / 120;
+	accumulator = 0;
+	fixedFrameTime = 0;
+	maxCatchUpSteps = 8;
+	interpolationAlpha = 0;
+	simulationThreaded = false;
+	simulationRunning = false;
+	tickTimeStamp = 0;
+	idleFrameRate = 10;
+	idleStats = IdleStats();
 	paused = false;
 	shouldClose = false;
 
@@ -20,10 +47,32 @@ void World::Run()
 	if (!window)
 		return;
 
+	// Startup is over, report how much of it went into building shader programs
+	ShaderCache::PrintStats();
+
+	// Closed by the first frame that finds every queued asset uploaded
+	StartupReport::BeginPhase("Asset streaming");
+
+	if (simulationThreaded) {
+		simulationRunning = true;
+		simulationThread = std::thread(&World::SimulationLoop, this);
+	}
+
+	std::clock_t cpuStart = std::clock();
 	while (!window->ShouldClose())
 	{
 		LoopUpdate();
 	}
+
+	if (simulationThread.joinable()) {
+		simulationRunning = false;
+		simulationThread.join();
+	}
+
+	PrintIdleStats();
+	std::string cpuTime;
+	Log::AppendFormat(cpuTime, "  Process CPU time: %.1f s", double(std::clock() - cpuStart) / CLOCKS_PER_SEC);
+	Log::Report(cpuTime);
 }
 
 void World::Pause()
@@ -42,31 +91,244 @@ double World::GetLastFrameTime()
 	return deltaTime;
 }
 
+void World::SetTickRate(double ticksPerSecond)
+{
+	tickTime = 1.0 / ticksPerSecond;
+	accumulator = 0;
+}
+
+double World::GetTickRate()
+{
+	return 1.0 / tickTime;
+}
+
+void World::SetMaxCatchUpSteps(unsigned int steps)
+{
+	maxCatchUpSteps = steps > 0 ? steps : 1;
+}
+
+double World::GetTickTimeStamp()
+{
+	return tickTimeStamp.load(std::memory_order_relaxed);
+}
+
+float World::GetInterpolationAlpha(double stateTime)
+{
+	if (!simulationThreaded)
+		return interpolationAlpha;
+
+	double sinceTick = elapsedTime - stateTime;
+	return static_cast<float>(std::min(std::max(sinceTick / tickTime, 0.0), 1.0));
+}
+
+void World::SetFixedFrameTime(double seconds)
+{
+	fixedFrameTime = seconds;
+}
+
+void World::SetSimulationThread(bool enabled)
+{
+	simulationThreaded = enabled;
+}
+
+bool World::IsSimulationThreaded()
+{
+	return simulationThreaded;
+}
+
+void World::SetIdleFrameRate(double framesPerSecond)
+{
+	idleFrameRate = framesPerSecond;
+}
+
 void World::ComputeFrameDeltaTime()
 {
 	elapsedTime = Engine::GetElapsedTime();
-	deltaTime = elapsedTime - previousTime;
+	deltaTime = fixedFrameTime > 0 ? fixedFrameTime : elapsedTime - previousTime;
 	previousTime = elapsedTime;
 }
 
+void World::RunFixedUpdates()
+{
+	PROFILE_SCOPE("FixedUpdate");
+
+	accumulator += deltaTime;
+
+	unsigned int steps = 0;
+	while (accumulator >= tickTime && steps < maxCatchUpSteps)
+	{
+		FixedUpdate(static_cast<float>(tickTime));
+		accumulator -= tickTime;
+		steps++;
+	}
+
+	// Past the clamp the simulation slows down rather than spiralling, only the partial tick is kept
+	if (accumulator >= tickTime)
+		accumulator = fmod(accumulator, tickTime);
+
+	interpolationAlpha = static_cast<float>(accumulator / tickTime);
+}
+
+void World::SimulationLoop()
+{
+	Profiler::SetThreadName("Simulation");
+
+	// The default Windows timer rounds sleeps up to ~15.6 ms, longer than a tick
+	#ifdef _WIN32
+	timeBeginPeriod(1);
+	#endif
+
+	double nextTick = Engine::GetElapsedTime();
+	while (simulationRunning)
+	{
+		double now = Engine::GetElapsedTime();
+		if (now < nextTick) {
+			std::this_thread::sleep_for(std::chrono::duration<double>(nextTick - now));
+			continue;
+		}
+
+		// Same clamp as the single-threaded loop, a stall longer than the catch-up window is dropped
+		if (now - nextTick > maxCatchUpSteps * tickTime)
+			nextTick = now;
+
+		// Stamped with the schedule rather than the wall clock, so late wake-ups do not show as uneven steps
+		tickTimeStamp.store(nextTick, std::memory_order_relaxed);
+		{
+			PROFILE_SCOPE("FixedUpdate");
+			FixedUpdate(static_cast<float>(tickTime));
+		}
+		nextTick += tickTime;
+	}
+
+	#ifdef _WIN32
+	timeEndPeriod(1);
+	#endif
+}
+
 void World::LoopUpdate()
 {
+	uint64_t frameStart = Profiler::Now();
+	PROFILE_SCOPE("Frame");
+
 	// Polls and buffers the events
-	window->PollEvents();
+	{
+		PROFILE_SCOPE("PollEvents");
+		window->PollEvents();
+	}
 
 	// Computes frame deltaTime in seconds
 	ComputeFrameDeltaTime();
 
+	// Uploads assets finished by the loader threads, within the frame budget
+	{
+		PROFILE_SCOPE("AssetLoader::Update");
+		AssetLoader::Update();
+	}
+
+	if (!StartupReport::IsFinished() && AssetLoader::GetPendingCount() == 0)
+		StartupReport::Finish();
+
+	// Swaps in shader programs rebuilt after their sources changed on disk
+	{
+		PROFILE_SCOPE("ShaderReloader::Update");
+		ShaderReloader::Update();
+	}
+
 	// Calls the methods of the instance of InputController in the following order
 	// OnWindowResize, OnMouseMove, OnMouseBtnPress, OnMouseBtnRelease, OnMouseScroll, OnKeyPress, OnMouseScroll, OnInputUpdate
 	// OnInputUpdate will be called each frame, the other functions are called only if an event is registered
-	window->UpdateObservers();
+	{
+		PROFILE_SCOPE("UpdateObservers");
+		window->UpdateObservers();
+	}
+
+	// Simulation catches up with the clock in fixed steps, unless it ticks on its own thread
+	if (!simulationThreaded)
+		RunFixedUpdates();
 
 	// Frame processing
-	FrameStart();
-	Update(static_cast<float>(deltaTime));
-	FrameEnd();
+	GpuProfiler::BeginFrame();
+	{
+		PROFILE_SCOPE("FrameStart");
+		FrameStart();
+	}
+	{
+		PROFILE_SCOPE("Update");
+		Update(static_cast<float>(deltaTime));
+	}
+	{
+		PROFILE_SCOPE("FrameEnd");
+		FrameEnd();
+	}
+
+	// Reads back the finished frame for screenshots and recordings without waiting for the GPU
+	{
+		PROFILE_SCOPE("FrameCapture::Update");
+		FrameCapture::Update();
+	}
+	GpuProfiler::EndFrame();
+	GpuProfiler::DrawOverlay(window->GetResolution());
 
 	// Swap front and back buffers - image will be displayed to the screen
-	window->SwapBuffers();
+	{
+		PROFILE_SCOPE("SwapBuffers");
+		window->SwapBuffers();
+	}
+	LatencyTracker::EndFrame();
+
+	ThrottleIdleFrame(frameStart);
+}
+
+void World::ThrottleIdleFrame(uint64_t frameStart)
+{
+	double busy = (Profiler::Now() - frameStart) / 1e9;
+
+	// Headless runs are frame-limited captures, they always go at full rate
+	bool idle = idleFrameRate >= 0 && !window->IsHeadless() && !window->HadInput() &&
+		AssetLoader::GetPendingCount() == 0 && IsIdle();
+
+	if (idle) {
+		PROFILE_SCOPE("IdleWait");
+		if (idleFrameRate == 0)
+			window->WaitEvents(-1);
+		else if (busy < 1 / idleFrameRate)
+			window->WaitEvents(1 / idleFrameRate - busy);
+	}
+
+	double frameTime = (Profiler::Now() - frameStart) / 1e9;
+	idleStats.frames++;
+	if (idle) {
+		idleStats.idleFrames++;
+		idleStats.idleTime += frameTime;
+		idleStats.idleBusy += busy;
+	}
+	else {
+		idleStats.activeTime += frameTime;
+		idleStats.activeBusy += busy;
+	}
+}
+
+void World::PrintIdleStats()
+{
+	const IdleStats &stats = idleStats;
+	double session = stats.activeTime + stats.idleTime;
+	if (session <= 0)
+		return;
+
+	std::string report = "=====================================================\n";
+	Log::AppendFormat(report, "Idle throttling: idle %.1f s of %.1f s (%.0f%%), %llu of %llu frames\n", stats.idleTime,
+		session, 100 * stats.idleTime / session, stats.idleFrames, stats.frames);
+
+	// The render thread's share of a core while active stands in for what the idle time would have cost,
+	// CPU time being the closest thing to power use measurable here
+	double activeDuty = stats.activeTime > 0 ? stats.activeBusy / stats.activeTime : 1;
+	double idleDuty = stats.idleTime > 0 ? stats.idleBusy / stats.idleTime : 0;
+	double saved = stats.idleTime * activeDuty - stats.idleBusy;
+	Log::AppendFormat(report, "  Render thread busy %.0f%% while active, %.0f%% while idle\n", 100 * activeDuty,
+		100 * idleDuty);
+	Log::AppendFormat(report, "  CPU time saved: %.1f s (%.0f%% of the session)\n", saved, 100 * saved / session);
+	if (stats.activeTime > 0 && stats.frames > stats.idleFrames)
+		Log::AppendFormat(report, "  Frames not rendered: %.0f\n",
+			stats.idleTime * (stats.frames - stats.idleFrames) / stats.activeTime - stats.idleFrames);
+	Log::Report(report);
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <thread>
 #include <unordered_map>
 
 class Mesh;
@@ -14,8 +17,14 @@ class World : public InputController
 		virtual ~World() {};
 		virtual void Init() {};
 		virtual void FrameStart() {};
+		// Simulation step, called at the tick rate (zero or more times per frame) before FrameStart,
+		// or on the simulation thread when SetSimulationThread is on
+		virtual void FixedUpdate(float stepSeconds) {};
+		// Called once per frame, renders the state blended by GetInterpolationAlpha(stateTime)
 		virtual void Update(float deltaTimeSeconds) {};
 		virtual void FrameEnd() {};
+		// Nothing on screen would change without input; frames are throttled while it holds (render thread)
+		virtual bool IsIdle() { return false; };
 
 		virtual void Run() final;
 		virtual void Pause() final;
@@ -23,14 +32,59 @@ class World : public InputController
 
 		virtual double GetLastFrameTime() final;
 
+		virtual void SetTickRate(double ticksPerSecond) final;
+		virtual double GetTickRate() final;
+		// A frame runs at most this many ticks, the rest of a long hitch is dropped instead of caught up
+		virtual void SetMaxCatchUpSteps(unsigned int steps) final;
+		// Clock time the state computed by the running FixedUpdate belongs to (the tick's scheduled time, not when it
+		// happened to run). Store it with the state handed to the render thread
+		virtual double GetTickTimeStamp() final;
+		// Fraction of a tick this frame's clock is past the state stamped stateTime, 0 = previous state,
+		// 1 = current state. Computed for the state actually drawn, so that a tick published mid-frame is not blended
+		// with the alpha of the one before. Without the simulation thread the stamp is not needed, the frame's own
+		// ticks decide
+		virtual float GetInterpolationAlpha(double stateTime) final;
+		// Advances the clock by a constant time each frame instead of the measured one (0 = wall clock),
+		// used for reproducible runs
+		virtual void SetFixedFrameTime(double seconds) final;
+		// Ticks FixedUpdate on its own thread, paced by the clock and independent of the frame rate. Must be set
+		// before Run; FixedUpdate then may only share data with the render thread through thread-safe handoffs
+		virtual void SetSimulationThread(bool enabled) final;
+		virtual bool IsSimulationThreaded() final;
+		// Frame rate cap while idle, 0 redraws only on input or WakeUp, negative never throttles
+		virtual void SetIdleFrameRate(double framesPerSecond) final;
+
 	private:
 		void ComputeFrameDeltaTime();
+		void RunFixedUpdates();
+		void SimulationLoop();
 		void LoopUpdate();
+		void ThrottleIdleFrame(uint64_t frameStart);
+		void PrintIdleStats();
 
 	private:
 		double previousTime;
 		double elapsedTime;
 		double deltaTime;
+		double tickTime;
+		double accumulator;
+		double fixedFrameTime;
+		unsigned int maxCatchUpSteps;
+		float interpolationAlpha;
+		bool simulationThreaded;
+		std::thread simulationThread;
+		std::atomic<bool> simulationRunning;
+		// Scheduled time of the last FixedUpdate of the simulation thread
+		std::atomic<double> tickTimeStamp;
+
+		double idleFrameRate;
+		// Session totals in seconds: wall time of the frames, and the part spent working rather than waiting
+		struct IdleStats
+		{
+			unsigned long long frames, idleFrames;
+			double activeTime, activeBusy;
+			double idleTime, idleBusy;
+		} idleStats;
 		bool paused;
 		bool shouldClose;
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
-#include <iostream>
+#include <string>
 
 using namespace std;
 
@@ -15,16 +17,108 @@ int main(int argc, char **argv) {
   wp.name = "8 Ball Pool";
   wp.resolution = glm::ivec2(1280, 720);
 
+  // --headless renders offscreen (no display needed), --frames N stops after N
+  // frames and --screenshot file.png saves the last one. --benchmark runs the
+  // scripted camera paths and writes a JSON report (benchmark.json by default).
+  // --startup-budget SECONDS fails the run when startup took longer,
+  // --tick-rate HZ sets the simulation rate (120 by default) and
+  // --no-sim-thread ticks the simulation on the render thread. --idle-fps N
+  // caps the frame rate while nothing changes (10 by default, 0 redraws only
+  // on input, -1 never throttles). --target-gpu-ms MS scales the render
+  // resolution to keep the GPU frame time under MS. --record-shots PREFIX
+  // records every shot as a PNG sequence, --record-format raw as a raw RGBA
+  // video stream instead. --latency measures input-to-photon latency and
+  // prints its percentiles on exit. --log-file PATH also writes every message
+  // with its time, level and thread to PATH, --log-level debug|info|warn|error
+  // skips the messages below that level (info by default)
+  unsigned int benchmark_frames = 0;
+  std::string benchmark_output = "benchmark.json";
+  double tick_rate = 0;
+  bool sim_thread = true;
+  double idle_fps = 10;
+  double target_gpu_ms = 0;
+  bool latency = false;
+  std::string record_shots;
+  FrameCapture::Format record_format = FrameCapture::Format::PNG_SEQUENCE;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--headless")
+      wp.headless = true;
+    else if (arg == "--resolution" && i + 1 < argc)
+      sscanf(argv[++i], "%dx%d", &wp.resolution.x, &wp.resolution.y);
+    else if (arg == "--frames" && i + 1 < argc)
+      wp.frameLimit = static_cast<unsigned int>(atoi(argv[++i]));
+    else if (arg == "--screenshot" && i + 1 < argc)
+      wp.screenshotFile = argv[++i];
+    else if (arg == "--benchmark")
+      benchmark_frames = 300;
+    else if (arg == "--benchmark-frames" && i + 1 < argc)
+      benchmark_frames = static_cast<unsigned int>(atoi(argv[++i]));
+    else if (arg == "--benchmark-output" && i + 1 < argc)
+      benchmark_output = argv[++i];
+    else if (arg == "--startup-budget" && i + 1 < argc)
+      StartupReport::SetBudget(atof(argv[++i]));
+    else if (arg == "--tick-rate" && i + 1 < argc)
+      tick_rate = atof(argv[++i]);
+    else if (arg == "--no-sim-thread")
+      sim_thread = false;
+    else if (arg == "--idle-fps" && i + 1 < argc)
+      idle_fps = atof(argv[++i]);
+    else if (arg == "--target-gpu-ms" && i + 1 < argc)
+      target_gpu_ms = atof(argv[++i]);
+    else if (arg == "--latency")
+      latency = true;
+    else if (arg == "--record-shots" && i + 1 < argc)
+      record_shots = argv[++i];
+    else if (arg == "--record-format" && i + 1 < argc)
+      record_format = std::string(argv[++i]) == "raw"
+                          ? FrameCapture::Format::RAW_VIDEO
+                          : FrameCapture::Format::PNG_SEQUENCE;
+    else if (arg == "--log-file" && i + 1 < argc)
+      Log::SetFile(argv[++i]);
+    else if (arg == "--log-level" && i + 1 < argc) {
+      std::string level = argv[++i];
+      if (level == "debug")
+        Log::SetLevel(LogLevel::DEBUG);
+      else if (level == "warn")
+        Log::SetLevel(LogLevel::WARN);
+      else if (level == "error")
+        Log::SetLevel(LogLevel::ERR);
+      else
+        Log::SetLevel(LogLevel::INFO);
+    } else
+      Log::Warn("Unknown argument " + arg);
+  }
+
   // Init the Engine and create a new window with the defined properties
   WindowObject *window = Engine::Init(wp);
+  if (latency) LatencyTracker::SetEnabled(true);
 
   // Create a new 3D world and start running it
-  World *world = new pool::Game();
+  pool::Game *game = new pool::Game();
+  if (tick_rate > 0) game->SetTickRate(tick_rate);
+  game->SetSimulationThread(sim_thread);
+  game->SetIdleFrameRate(idle_fps);
+  game->SetTargetFrameTime(target_gpu_ms);
+  game->SetRecordShots(record_shots, record_format);
+  if (benchmark_frames)
+    game->SetBenchmark(
+        new pool::Benchmark(benchmark_frames, benchmark_output));
+
+  World *world = game;
   world->Init();
   world->Run();
 
   // Signals to the Engine to release the OpenGL context
   Engine::Exit();
 
+  if (StartupReport::IsOverBudget()) {
+    // The logger is stopped, this is written right away
+    Log::Error("Startup over budget",
+               {{"startup_ms", StartupReport::GetTotalTime() * 1000},
+                {"budget_ms", StartupReport::GetBudget() * 1000}});
+    return 1;
+  }
+
   return 0;
 }
\ No newline at end of file
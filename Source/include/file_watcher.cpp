@@ -0,0 +1,111 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <sys/stat.h>
+
+#ifdef __linux__
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/inotify.h>
+#endif
+
+namespace
+{
+	long long GetModificationTime(const std::string &file)
+	{
+		struct stat fileInfo;
+		if (stat(file.c_str(), &fileInfo) != 0)
+			return 0;
+		return static_cast<long long>(fileInfo.st_mtime);
+	}
+
+	std::string GetDirectory(const std::string &file)
+	{
+		size_t separator = file.find_last_of("/\\");
+		return separator == std::string::npos ? "./" : file.substr(0, separator + 1);
+	}
+}
+
+FileWatcher::FileWatcher()
+{
+	#ifdef __linux__
+	inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	#ifdef __linux__
+	if (inotifyDescriptor >= 0)
+		close(inotifyDescriptor);
+	#endif
+}
+
+void FileWatcher::Add(const std::string &file)
+{
+	if (files.count(file))
+		return;
+	files[file] = GetModificationTime(file);
+
+	#ifdef __linux__
+	if (inotifyDescriptor < 0)
+		return;
+
+	std::string directory = GetDirectory(file);
+	int watchDescriptor = inotify_add_watch(inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watchDescriptor < 0)
+		return;
+
+	// The same directory reached through different paths shares one watch descriptor
+	auto &spellings = directories[watchDescriptor];
+	if (std::find(spellings.begin(), spellings.end(), directory) == spellings.end())
+		spellings.push_back(directory);
+	#endif
+}
+
+void FileWatcher::Remove(const std::string &file)
+{
+	// Directory watches are kept, events for files that are no longer watched are dropped in Poll
+	files.erase(file);
+}
+
+void FileWatcher::Poll(std::vector<std::string> &changedFiles)
+{
+	size_t firstChange = changedFiles.size();
+
+	#ifdef __linux__
+	if (inotifyDescriptor >= 0)
+	{
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(inotifyDescriptor, buffer, sizeof(buffer))) > 0)
+		{
+			for (char *cursor = buffer; cursor < buffer + length; )
+			{
+				const inotify_event *event = reinterpret_cast<const inotify_event*>(cursor);
+				cursor += sizeof(inotify_event) + event->len;
+
+				auto directory = directories.find(event->wd);
+				if (directory == directories.end() || event->len == 0)
+					continue;
+
+				for (auto &spelling : directory->second) {
+					std::string file = spelling + event->name;
+					if (files.count(file) && std::find(changedFiles.begin() + firstChange, changedFiles.end(), file) == changedFiles.end())
+						changedFiles.push_back(file);
+				}
+			}
+		}
+		return;
+	}
+	#endif
+
+	for (auto &file : files)
+	{
+		long long modificationTime = GetModificationTime(file.first);
+		if (modificationTime != file.second) {
+			file.second = modificationTime;
+			changedFiles.push_back(file.first);
+		}
+	}
+}
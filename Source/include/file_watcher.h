@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// -------------------------------------------------------------------------
+// Reports files that were written since the last Poll()
+// Uses inotify on Linux (the parent directories are watched so editors that save by rename are caught)
+// and falls back to comparing modification times elsewhere
+
+class FileWatcher
+{
+	public:
+		FileWatcher();
+		~FileWatcher();
+
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		void Add(const std::string &file);
+		void Remove(const std::string &file);
+
+		// Non-blocking, appends every changed watched file once
+		void Poll(std::vector<std::string> &changedFiles);
+
+	private:
+		// Modification time per watched file, only used by the polling fallback
+		std::unordered_map<std::string, long long> files;
+
+		#ifdef __linux__
+		int inotifyDescriptor;
+		// Watch descriptor -> every spelling of the watched directory (with trailing separator)
+		std::unordered_map<int, std::vector<std::string>> directories;
+		#endif
+};
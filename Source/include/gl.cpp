@@ -1,6 +1,6 @@
 #include "gl.h"
 
-#include <iostream>
+#include <Core/Logging/Log.h>
 
 using namespace std;
 
@@ -16,8 +16,7 @@ static string GLerrorDescription[] = {
 
 void PrintGLErrorDescription(unsigned int glErr)
 {
-	cout << "\n[OpenGL Error]\n";
-	cout << "\t[" << glErr << "] : " << GLerrorDescription[glErr - GL_INVALID_ENUM].c_str() << "\n";
+	Log::Error("[OpenGL Error]", { { "code", glErr }, { "error", GLerrorDescription[glErr - GL_INVALID_ENUM] } });
 }
 
 int OpenGL::CheckError(const char * file, int line, bool log)
@@ -26,8 +25,8 @@ int OpenGL::CheckError(const char * file, int line, bool log)
 		GLenum glErr = glGetError();
 		if (glErr != GL_NO_ERROR && log)
 		{
-			PrintGLErrorDescription(glErr);
-			cout << "\t[File] : " << file << "\t[Line] : " << line << endl;
+			Log::Error("[OpenGL Error]", { { "code", glErr }, { "error", GLerrorDescription[glErr - GL_INVALID_ENUM] },
+				{ "file", file }, { "line", line } });
 			return glErr;
 		}
 	#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.h"
+
+// -------------------------------------------------------------------------
+// 64-bit FNV-1a hash, used as content key for the on-disk caches
+// Pass the previous result as seed to hash several buffers in sequence
+
+#define FNV1A_64_SEED		14695981039346656037ULL
+#define FNV1A_64_PRIME		1099511628211ULL
+
+inline uint64_t HashFNV1a(const void *data, size_t size, uint64_t seed = FNV1A_64_SEED)
+{
+	const unsigned char *bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV1A_64_PRIME;
+	}
+	return hash;
+}
+
+inline uint64_t HashFNV1a(const std::string &str, uint64_t seed = FNV1A_64_SEED)
+{
+	return HashFNV1a(str.data(), str.size(), seed);
+}
+
+// Hashes the contents of file (memory mapped) on top of seed, fileSize receives the bytes read
+// Returns false when the file cannot be opened
+inline bool HashFile(const std::string &file, uint64_t &hash, uint64_t seed = FNV1A_64_SEED, size_t *fileSize = nullptr)
+{
+	MappedFile source;
+	if (!source.Open(file.c_str()))
+		return false;
+	hash = HashFNV1a(source.GetData(), source.GetSize(), seed);
+	if (fileSize)
+		*fileSize = source.GetSize();
+	return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+// -------------------------------------------------------------------------
+// Read-only memory mapping of a whole file
+// The mapping is released when the object is destroyed or Close() is called
+
+class MappedFile
+{
+	public:
+		MappedFile();
+		MappedFile(MappedFile &&other);
+		MappedFile& operator=(MappedFile &&other);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const char *fileName);
+		void Close();
+
+		bool IsOpen() const;
+		const unsigned char* GetData() const;
+		size_t GetSize() const;
+
+	private:
+		const unsigned char *data;
+		size_t size;
+
+		// Native handles
+		#ifdef _WIN32
+		void *fileHandle;
+		void *mappingHandle;
+		#else
+		int fileDescriptor;
+		#endif
+};
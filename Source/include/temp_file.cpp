@@ -0,0 +1,41 @@
+#include "temp_file.h"
+
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+std::string MakeTempFileName(const std::string &file)
+{
+	#ifdef _WIN32
+	unsigned long processID = GetCurrentProcessId();
+	#else
+	unsigned long processID = static_cast<unsigned long>(getpid());
+	#endif
+	size_t threadID = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+	char suffix[64];
+	snprintf(suffix, sizeof(suffix), ".%lu.%zx.tmp", processID, threadID);
+	return file + suffix;
+}
+
+bool CommitTempFile(const std::string &tempFile, const std::string &target)
+{
+	// rename() does not replace an existing file on Windows
+	#ifdef _WIN32
+	bool moved = MoveFileExA(tempFile.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+	#else
+	bool moved = rename(tempFile.c_str(), target.c_str()) == 0;
+	#endif
+
+	if (!moved)
+		remove(tempFile.c_str());
+	return moved;
+}
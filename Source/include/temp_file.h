@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+// -------------------------------------------------------------------------
+// Files written in full under a temporary name, then moved over the target
+// Readers see the previous file or the new one, never a partial write, and concurrent writers of the same target
+// each get their own temporary file (the last move wins)
+
+// "<file>.<process>.<thread>.tmp"
+std::string MakeTempFileName(const std::string &file);
+
+// Moves tempFile over target in one step, replacing it if it exists. Removes tempFile on failure
+bool CommitTempFile(const std::string &tempFile, const std::string &target);
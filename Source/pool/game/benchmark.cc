@@ -0,0 +1,215 @@
+#include "pool/game/benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include <include/gl.h>
+#include <Core/Engine.h>
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/Statistics.h>
+
+namespace pool {
+const float Benchmark::kFixedTimeStep = 1.0f / 60.0f;
+const unsigned int Benchmark::kWarmupFrames = 10;
+
+namespace {
+const char *kPhaseNames[] = {"loading",      "top_down", "third_person",
+                             "first_person", "break",    "draining",
+                             "done"};
+const int kFirstMeasuredPhase = static_cast<int>(BenchmarkPhase::TOP_DOWN);
+const int kNrMeasuredPhases = static_cast<int>(BenchmarkPhase::BREAK) -
+                              kFirstMeasuredPhase + 1;
+
+double Mean(const std::vector<double> &values) {
+  if (values.empty()) return 0;
+  double sum = 0;
+  for (auto value : values) sum += value;
+  return sum / values.size();
+}
+
+void WriteDistribution(FILE *out, const char *name,
+                       std::vector<double> values) {
+  if (values.empty()) {
+    fprintf(out, "\"%s\":null", name);
+    return;
+  }
+  std::sort(values.begin(), values.end());
+  fprintf(out,
+          "\"%s\":{\"mean\":%.4f,\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f,"
+          "\"max\":%.4f}",
+          name, Mean(values), Percentile(values, 50), Percentile(values, 95),
+          Percentile(values, 99), values.back());
+}
+
+void Append(std::vector<double> &to, const std::vector<double> &from) {
+  to.insert(to.end(), from.begin(), from.end());
+}
+}  // namespace
+
+Benchmark::Benchmark(unsigned int frames_per_phase,
+                     const std::string &output_file)
+    : frames_per_phase_(frames_per_phase),
+      output_file_(output_file),
+      phase_(BenchmarkPhase::LOADING),
+      phase_frame_(0),
+      frame_start_(0),
+      previous_frame_start_(0),
+      first_frame_id_(0),
+      last_gpu_frame_id_(0),
+      samples_(kNrMeasuredPhases) {
+  // Pass timings and draw counters come from the GPU profiler
+  GpuProfiler::SetEnabled(true);
+}
+
+Benchmark::~Benchmark() {}
+
+unsigned int Benchmark::GetPhaseLength() {
+  return phase_ == BenchmarkPhase::DRAINING ? GpuProfiler::FRAME_LATENCY + 1
+                                            : kWarmupFrames + frames_per_phase_;
+}
+
+BenchmarkPhase Benchmark::BeginFrame(bool scene_ready) {
+  previous_frame_start_ = frame_start_;
+  frame_start_ = Profiler::Now();
+
+  if (phase_ == BenchmarkPhase::LOADING) {
+    if (!scene_ready) return phase_;
+    Log::Info("[Benchmark] Scene loaded, measuring " +
+              std::to_string(frames_per_phase_) + " frames per phase");
+    first_frame_id_ = GpuProfiler::GetFrameID();
+    phase_ = BenchmarkPhase::TOP_DOWN;
+    phase_frame_ = 0;
+  } else if (phase_ != BenchmarkPhase::DONE) {
+    // The interval since the previous frame belongs to that frame
+    int previous = frame_phases_.empty() ? -1 : frame_phases_.back();
+    if (previous >= 0)
+      samples_[previous].frame_ms.push_back(
+          (frame_start_ - previous_frame_start_) / 1e6);
+
+    CollectGpuStats();
+
+    phase_frame_++;
+    if (phase_frame_ >= GetPhaseLength()) NextPhase();
+  }
+
+  bool measured = phase_ >= BenchmarkPhase::TOP_DOWN &&
+                  phase_ <= BenchmarkPhase::BREAK &&
+                  phase_frame_ >= kWarmupFrames;
+  frame_phases_.push_back(
+      measured ? static_cast<int>(phase_) - kFirstMeasuredPhase : -1);
+  return phase_;
+}
+
+void Benchmark::EndFrame() {
+  if (phase_ == BenchmarkPhase::LOADING || frame_phases_.empty()) return;
+
+  int current = frame_phases_.back();
+  if (current >= 0)
+    samples_[current].cpu_ms.push_back((Profiler::Now() - frame_start_) /
+                                       1e6);
+}
+
+void Benchmark::NextPhase() {
+  phase_ = static_cast<BenchmarkPhase>(static_cast<int>(phase_) + 1);
+  phase_frame_ = 0;
+  if (phase_ != BenchmarkPhase::DONE)
+    Log::Info(std::string("[Benchmark] ") +
+              kPhaseNames[static_cast<int>(phase_)]);
+}
+
+void Benchmark::CollectGpuStats() {
+  // Results arrive GpuProfiler::FRAME_LATENCY frames late, or not at all when
+  // the GPU was still busy with the frame
+  unsigned long long frame_id = GpuProfiler::GetLastFrameID();
+  if (frame_id == last_gpu_frame_id_ || frame_id < first_frame_id_) return;
+  last_gpu_frame_id_ = frame_id;
+
+  size_t index = static_cast<size_t>(frame_id - first_frame_id_);
+  if (index >= frame_phases_.size() || frame_phases_[index] < 0) return;
+  Samples &samples = samples_[frame_phases_[index]];
+
+  double gpu_ms = 0, draw_calls = 0, triangles = 0, state_changes = 0;
+  bool timed = true;
+  for (auto &pass : GpuProfiler::GetLastFrame()) {
+    timed = timed && pass.gpuMs >= 0;
+    gpu_ms += pass.gpuMs;
+    draw_calls += pass.drawCalls;
+    triangles += static_cast<double>(pass.triangles);
+    state_changes += pass.stateChanges;
+  }
+
+  if (timed) samples.gpu_ms.push_back(gpu_ms);
+  samples.draw_calls.push_back(draw_calls);
+  samples.triangles.push_back(triangles);
+  samples.state_changes.push_back(state_changes);
+}
+
+bool Benchmark::WriteReport() {
+  FILE *out = fopen(output_file_.c_str(), "w");
+  if (!out) {
+    Log::Error("[Benchmark] Could not write " + output_file_);
+    return false;
+  }
+
+  glm::ivec2 resolution = Engine::GetWindow()->GetResolution();
+  fprintf(out, "{\"renderer\":\"%s\",\"version\":\"%s\",",
+          reinterpret_cast<const char *>(glGetString(GL_RENDERER)),
+          reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+  fprintf(out, "\"resolution\":[%d,%d],\"frames_per_phase\":%u,",
+          resolution.x, resolution.y, frames_per_phase_);
+  fprintf(out, "\"warmup_frames\":%u,\"time_step\":%.6f,", kWarmupFrames,
+          kFixedTimeStep);
+  fprintf(out,
+          "\"startup\":{\"total_ms\":%.2f,\"budget_ms\":%.2f,"
+          "\"over_budget\":%s},\"phases\":{",
+          StartupReport::GetTotalTime() * 1000,
+          StartupReport::GetBudget() * 1000,
+          StartupReport::IsOverBudget() ? "true" : "false");
+
+  Samples overall;
+  for (int i = 0; i < kNrMeasuredPhases; i++) {
+    const Samples &samples = samples_[i];
+    Append(overall.frame_ms, samples.frame_ms);
+    Append(overall.cpu_ms, samples.cpu_ms);
+    Append(overall.gpu_ms, samples.gpu_ms);
+    Append(overall.draw_calls, samples.draw_calls);
+    Append(overall.triangles, samples.triangles);
+    Append(overall.state_changes, samples.state_changes);
+  }
+
+  for (int i = 0; i <= kNrMeasuredPhases; i++) {
+    const Samples &samples = i < kNrMeasuredPhases ? samples_[i] : overall;
+    if (i == kNrMeasuredPhases)
+      fprintf(out, "},\"overall\":{");
+    else
+      fprintf(out, "%s\"%s\":{", i ? "," : "",
+              kPhaseNames[i + kFirstMeasuredPhase]);
+
+    fprintf(out, "\"frames\":%zu,", samples.cpu_ms.size());
+    WriteDistribution(out, "frame_ms", samples.frame_ms);
+    fprintf(out, ",");
+    WriteDistribution(out, "cpu_ms", samples.cpu_ms);
+    fprintf(out, ",");
+    WriteDistribution(out, "gpu_ms", samples.gpu_ms);
+    fprintf(out,
+            ",\"draw_calls\":%.2f,\"triangles\":%.0f,\"state_changes\":%.2f}",
+            Mean(samples.draw_calls), Mean(samples.triangles),
+            Mean(samples.state_changes));
+
+    std::vector<double> frame_ms = samples.frame_ms;
+    std::sort(frame_ms.begin(), frame_ms.end());
+    Log::Info(std::string("[Benchmark] ") +
+                  (i < kNrMeasuredPhases ? kPhaseNames[i + kFirstMeasuredPhase]
+                                         : "overall"),
+              {{"frame_mean_ms", Mean(frame_ms)},
+               {"frame_p99_ms", Percentile(frame_ms, 99)}});
+  }
+  fprintf(out, "}\n");
+
+  bool ok = ferror(out) == 0;
+  fclose(out);
+  Log::Info("[Benchmark] Report written to " + output_file_);
+  return ok;
+}
+}  // namespace pool
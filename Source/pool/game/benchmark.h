@@ -0,0 +1,75 @@
+#ifndef POOL_BENCHMARK_H_
+#define POOL_BENCHMARK_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pool {
+enum class BenchmarkPhase {
+  LOADING,
+  TOP_DOWN,
+  THIRD_PERSON,
+  FIRST_PERSON,
+  BREAK,
+  DRAINING,
+  DONE
+};
+
+/*
+Scripted render benchmark. Game drives the camera through one phase after the
+other (each lasting a fixed number of frames) while this class times the
+frames and collects the GPU pass statistics, then writes mean/p50/p95/p99 per
+phase to a JSON file. The simulation runs on a fixed time step so every run
+renders the same frames.
+*/
+class Benchmark {
+ public:
+  // Frame time used instead of the measured one, see World::SetFixedFrameTime
+  static const float kFixedTimeStep;
+  // Frames at the start of every phase left out of the statistics
+  static const unsigned int kWarmupFrames;
+
+  Benchmark(unsigned int frames_per_phase, const std::string &output_file);
+  ~Benchmark();
+
+  // Called at the start of every frame, after GpuProfiler::BeginFrame. Waits
+  // in LOADING until scene_ready, then returns the phase to render
+  BenchmarkPhase BeginFrame(bool scene_ready);
+  void EndFrame();
+
+  inline BenchmarkPhase GetPhase() { return phase_; }
+  // Frame index inside the current phase, 0 on the first frame of a phase
+  inline unsigned int GetPhaseFrame() { return phase_frame_; }
+  // Frames rendered in the current phase, warm-up included
+  unsigned int GetPhaseLength();
+  inline bool IsDone() { return phase_ == BenchmarkPhase::DONE; }
+
+  bool WriteReport();
+
+ private:
+  struct Samples {
+    std::vector<double> frame_ms, cpu_ms, gpu_ms;
+    std::vector<double> draw_calls, triangles, state_changes;
+  };
+
+  void CollectGpuStats();
+  void NextPhase();
+
+  unsigned int frames_per_phase_;
+  std::string output_file_;
+
+  BenchmarkPhase phase_;
+  unsigned int phase_frame_;
+  uint64_t frame_start_, previous_frame_start_;
+
+  // Phase of every recorded frame, indexed by GpuProfiler frame id - first_frame_id_
+  std::vector<int> frame_phases_;
+  unsigned long long first_frame_id_, last_gpu_frame_id_;
+
+  // One entry per measured phase (TOP_DOWN to BREAK)
+  std::vector<Samples> samples_;
+};
+}  // namespace pool
+
+#endif  // POOL_BENCHMARK_H_
@@ -1,15 +1,29 @@
 #include "pool/game/game.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <vector>
 
 #include <Core/Engine.h>
+#include <Core/Logging/Log.h>
 #include <Engine/Component/Camera/Camera.h>
 
 using namespace std;
 
 namespace pool {
+namespace {
+// Layout of the Frame block in pool/shaders/Frame.glsl, std140 pads each
+// vec3 to 16 bytes
+struct FrameUniforms {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::vec4 light_position;
+  glm::vec4 eye_position;
+};
+}  // namespace
+
     ShadowMapFBO shadowMapFBO;
 
 #pragma region CONSTANTS
@@ -30,23 +44,62 @@ const glm::mat4 Game::kTableModelMatrix =
 const std::string Game::kPoolShaderName = "PoolShader";
 const std::string Game::shadowShaderName = "ShadowShader";
 const std::string Game::renderToTextureShaderName = "RenderToTexture";
+const GLuint Game::kFrameUniformsBinding = 0;
 #pragma endregion
 
-Game::Game() {}
+Game::Game()
+    : stroke_active_(false),
+      stroke_start_time_(0),
+      stroke_start_offset_(0),
+      stroke_start_speed_(0),
+      input_applied_(false),
+      was_idle_(false),
+      published_sequence_(0),
+      drawn_sequence_(0),
+      pending_input_time_(-1),
+      pending_input_applied_time_(0),
+      frame_(nullptr),
+      uniform_buffer_alignment_(256),
+      dynamic_resolution_(nullptr),
+      target_frame_time_(0),
+      record_shots_format_(FrameCapture::Format::PNG_SEQUENCE),
+      recorded_shots_(0),
+      recording_shot_(false),
+      benchmark_(nullptr) {
+  // Physics and rules keep their pace while the render thread waits on the GPU
+  SetSimulationThread(true);
+}
 
-Game::~Game() {}
+Game::~Game() {
+  delete dynamic_resolution_;
+  delete benchmark_;
+}
 
 void Game::Init() {
+  STARTUP_PHASE("Game::Init");
+
+  // Meshes are only queued here, AssetLoader imports them on its threads
+  StartupReport::BeginPhase("Mesh requests");
+
   // Table
   {
     table_ = new Mesh("table");
-    table_->LoadMesh(RESOURCE_PATH::MODELS + "Props", "table.obj");
+    AssetLoader::LoadMesh(table_, RESOURCE_PATH::MODELS + "Props", "table.obj");
 
     table_bed_ = new Mesh("table_bed");
-    table_bed_->LoadMesh(RESOURCE_PATH::MODELS + "Props", "table_bed.obj");
+    AssetLoader::LoadMesh(table_bed_, RESOURCE_PATH::MODELS + "Props",
+                          "table_bed.obj");
 
     table_metal_ = new Mesh("table_metal");
-    table_metal_->LoadMesh(RESOURCE_PATH::MODELS + "Props", "table_metal.obj");
+    AssetLoader::LoadMesh(table_metal_, RESOURCE_PATH::MODELS + "Props",
+                          "table_metal.obj");
+
+    // The three parts share kTableModelMatrix and are drawn as one batch,
+    // with materials in this order: table, metal, bed
+    table_batch_ = new StaticBatch();
+    table_batch_->Add(table_, 0);
+    table_batch_->Add(table_metal_, 1);
+    table_batch_->Add(table_bed_, 2);
   }
 
   // Pockets
@@ -118,9 +171,12 @@ void Game::Init() {
   // Lamp
   {
     lamp_ = new Mesh("lamp");
-    lamp_->LoadMesh(RESOURCE_PATH::MODELS + "Props", "lamp.obj");
+    AssetLoader::LoadMesh(lamp_, RESOURCE_PATH::MODELS + "Props", "lamp.obj");
     render_lamp_ = false;
   }
+  StartupReport::EndPhase();
+
+  StartupReport::BeginPhase("Shaders");
 
   // Shader
   {
@@ -129,8 +185,10 @@ void Game::Init() {
                       GL_VERTEX_SHADER);
     shader->AddShader("Source/pool/shaders/FragmentShader.glsl",
                       GL_FRAGMENT_SHADER);
+    // Program state, so it is set on link and reload rather than per draw
+    shader->SetUniformBlockBinding("Frame", kFrameUniformsBinding);
     shader->CreateAndLink();
-    shaders[shader->GetName()] = shader;
+    AddShaderToList(shader);
   }
 
   // Shadows shader
@@ -141,7 +199,7 @@ void Game::Init() {
       shader->AddShader("Source/pool/shadows/shaders/Shadow_FS.glsl",
           GL_FRAGMENT_SHADER);
       shader->CreateAndLink();
-      shaders[shader->GetName()] = shader;
+      AddShaderToList(shader);
   }
 
   // Shader for rendering to texture
@@ -152,9 +210,25 @@ void Game::Init() {
       shader->AddShader("Source/pool/shadows/shaders/Render_to_Texture_FS.glsl",
           GL_FRAGMENT_SHADER);
       shader->CreateAndLink();
-      shaders[shader->GetName()] = shader;
+      AddShaderToList(shader);
   }
 
+  // Resolved once, the render loop only indexes the shader pool
+  pool_shader_ = GetShaderHandle(kPoolShaderName);
+  shadow_shader_ = GetShaderHandle(shadowShaderName);
+
+  // Color writes are masked during the depth pass, so it can skip the specular
+  // BRDF altogether
+  depth_shader_ = GetShader(shadow_shader_)->GetVariant({"NO_SPECULAR"});
+  batch_shader_ = GetShader(pool_shader_)->GetVariant({"STATIC_BATCH"});
+
+  // Room for a few blocks per frame region, each one aligned to up to 256
+  // bytes (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+                &uniform_buffer_alignment_);
+  frame_uniforms_.Init(GL_UNIFORM_BUFFER, StreamBuffer::FRAME_REGIONS * 1024);
+  StartupReport::EndPhase();
+
   // Light & material properties
   {
     lamp_position_ = glm::vec3(0, 1.7, 0);
@@ -180,18 +254,35 @@ void Game::Init() {
     velvet_properties_.ks = 1.5f;
   }
 
+  StartupReport::BeginPhase("ShadowMapFBO::Init");
   shadowMapFBO = ShadowMapFBO();
   shadowMapFBO.Init(window->props.resolution.x, window->props.resolution.y);
+  StartupReport::EndPhase();
+
+  if (target_frame_time_ > 0) {
+    dynamic_resolution_ = new DynamicResolution();
+    dynamic_resolution_->SetTargetFrameTime(target_frame_time_);
+    if (!dynamic_resolution_->Init(window->GetResolution())) {
+      delete dynamic_resolution_;
+      dynamic_resolution_ = nullptr;
+    }
+  }
 
   setDefaultFrameBuffer();
 
   // Init game
   {
+    STARTUP_PHASE("StartGame");
     camera_ = new Camera(window->props.aspectRatio);
 
     StartGame();
     Break();
+    PublishSnapshot();
   }
+
+  // Cue strokes are timed from the button callbacks, the only samples read
+  window->SetInputSampling(
+      InputSample::Mask(InputSample::Type::MOUSE_BUTTON));
 }
 
 #pragma region GAME CONTROL
@@ -202,7 +293,7 @@ void Game::StartGame() {
   print_help_.emplace(GameStage::LOOK_AROUND, true);
   print_help_.emplace(GameStage::PLACE_CUE_BALL, true);
 
-  std::cout << std::endl << "Welcome to 8-ball-pool!" << std::endl;
+  Log::Info("\nWelcome to 8-ball-pool!");
   player_one_ = GetPlayerName("Player1");
   player_two_ = GetPlayerName("Player2");
 
@@ -212,9 +303,14 @@ void Game::StartGame() {
 }
 
 Player Game::GetPlayerName(std::string default) {
+  // Benchmarks run unattended
+  if (benchmark_) return Player(default);
+
+  // The prompt has to show after the queued lines, reading stdin blocks anyway
+  Log::Flush();
   std::string name;
   std::cout << "Please enter name for " << default
-            << " (press Enter for default): ";
+            << " (press Enter for default): " << std::flush;
   std::getline(std::cin, name);
   if (name.empty()) {
     name = default;
@@ -233,62 +329,92 @@ void Game::TogglePlayer() {
     current_player_ = &player_two_;
   else
     current_player_ = &player_one_;
-  std::cout << std::endl
-            << current_player_->GetName()
-            << "'s turn. Press SPACE to start your shot." << std::endl;
+  Log::Info("\n" + current_player_->GetName() +
+            "'s turn. Press SPACE to start your shot.");
 
   current_player_->Reset();
   press_space_to_continue_ = true;
 }
 
 void Game::Help() {
-  std::cout
-      << std::endl
-      << "=============================== HELP ==============================="
-      << std::endl
-      << "* General controls: Press V at any time to toggle LookAround mode"
-      << std::endl
-      << "and explore the world freely." << std::endl
-      << "* Look around controls: Look around using the mouse and the WASDEQ"
-      << std::endl
-      << "keys by pressing RIGHT_MOUSE_BUTTON. Press V again to go back to the"
-      << std::endl
-      << "previous mode." << std::endl
-      << "* Lamp controls: Press CTRL + the directional keys to move the lamp."
-      << std::endl
-      << "* Break controls: Place the cue ball using the WASD keys, then press"
-      << std::endl
-      << "SPACE to start your shot." << std::endl
-      << "* Place cue ball controls: You can place the cue ball anywhere using"
-      << std::endl
-      << "the WASD keys." << std::endl
-      << "* Hit cue ball controls: Press RIGHT_MOUSE_BUTTON and move mouse to"
-      << std::endl
-      << "position shot horizontally.Press LEFT_MOUSE_BUTTON to start moving"
-      << std::endl
-      << "cue, release to hit(the further the cue is from the ball, the"
-      << std::endl
-      << "stronger the shot)." << std::endl
-      << "===================================================================="
-      << std::endl;
-  ;
+  Log::Info(
+      "\n"
+      "=============================== HELP ===============================\n"
+      "* General controls: Press V at any time to toggle LookAround mode\n"
+      "and explore the world freely.\n"
+      "* Look around controls: Look around using the mouse and the WASDEQ\n"
+      "keys by pressing RIGHT_MOUSE_BUTTON. Press V again to go back to the\n"
+      "previous mode.\n"
+      "* Lamp controls: Press CTRL + the directional keys to move the lamp.\n"
+      "* Break controls: Place the cue ball using the WASD keys, then press\n"
+      "SPACE to start your shot.\n"
+      "* Place cue ball controls: You can place the cue ball anywhere using\n"
+      "the WASD keys.\n"
+      "* Hit cue ball controls: Press RIGHT_MOUSE_BUTTON and move mouse to\n"
+      "position shot horizontally.Press LEFT_MOUSE_BUTTON to start moving\n"
+      "cue, release to hit(the further the cue is from the ball, the\n"
+      "stronger the shot).\n"
+      "====================================================================");
+}
+
+void Game::SetTargetFrameTime(double milliseconds) {
+  target_frame_time_ = milliseconds;
+}
+
+void Game::SetRecordShots(const std::string &prefix,
+                          FrameCapture::Format format) {
+  record_shots_prefix_ = prefix;
+  record_shots_format_ = format;
+}
+
+void Game::SetBenchmark(Benchmark *benchmark) {
+  delete benchmark_;
+  benchmark_ = benchmark;
+
+  // Every frame advances the simulation by the same time, so that every run
+  // renders the same frames. The benchmark also moves the camera between
+  // ticks, so it keeps the simulation on the render thread
+  if (benchmark_) {
+    SetFixedFrameTime(Benchmark::kFixedTimeStep);
+    SetSimulationThread(false);
+  }
 }
 
 #pragma endregion
 
 void Game::FrameStart() {
+  if (benchmark_) {
+    UpdateBenchmark();
+    PublishSnapshot();
+  }
+
+  if (dynamic_resolution_) {
+    // The target follows the window size, its scale follows the GPU time
+    if (dynamic_resolution_->GetOutputResolution() != window->GetResolution())
+      dynamic_resolution_->Init(window->GetResolution());
+    dynamic_resolution_->Begin();
+  }
+
+  // Sets the screen area where to draw
+  setDefaultFrameBuffer();
+
   // clears the color buffer (using the previously set color) and depth buffer
   glClearColor(0, 0, 0, 1);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-  glm::ivec2 resolution = window->GetResolution();
-  // Sets the screen area where to draw
-  glViewport(0, 0, resolution.x, resolution.y);
 }
 
-void Game::Update(float delta_time_seconds) {
+void Game::FixedUpdate(float step_seconds) {
+  ApplyInputSamples();
+  InputEvent event;
+  while (input_queue_.TryPop(event)) ApplyInput(event);
+
+  // Shows the stroke as of this tick, the shot itself uses the release time
+  if (stroke_active_)
+    cue_offset_ = GetStrokeOffset(Engine::GetElapsedTime(), &cue_movement_speed_);
+
   // Collisions
   {
+    PROFILE_SCOPE("Collisions");
     bool none_moving = true;
     for (auto ball : balls_) {
       if (!ball->IsPotted()) {
@@ -297,7 +423,7 @@ void Game::Update(float delta_time_seconds) {
 
         // Pocket collisions
         for (auto pocket : pockets_) {
-          if (Ball::CheckCollision(ball, pocket, delta_time_seconds)) {
+          if (Ball::CheckCollision(ball, pocket, step_seconds)) {
             ball->SetPotted(true);
             pot_status = current_player_->PotBall(ball->GetColor());
           }
@@ -341,15 +467,16 @@ void Game::Update(float delta_time_seconds) {
 
           switch (pot_status) {
             case PotStatus::FAULT_CUE_BALL:
-              std::cout << "Fault! Potted the cue ball." << std::endl;
+              Log::Info("Fault! Potted the cue ball.",
+                        {{"player", current_player_->GetName()}});
               break;
             case PotStatus::FAULT_OPPONENT:
-              std::cout << "Fault! Potted opponent ball." << std::endl;
+              Log::Info("Fault! Potted opponent ball.",
+                        {{"player", current_player_->GetName()}});
               break;
             case PotStatus::LOSS:
-              std::cout << current_player_->GetName()
-                        << " lost by potting the black ball too early."
-                        << std::endl;
+              Log::Info(current_player_->GetName() +
+                        " lost by potting the black ball too early.");
               EndGame();
               break;
             case PotStatus::WIN:
@@ -365,15 +492,15 @@ void Game::Update(float delta_time_seconds) {
           none_moving = false;
           for (auto another_ball : balls_) {
             if (another_ball == ball || another_ball->IsPotted()) continue;
-            if (Ball::CheckCollision(ball, another_ball, delta_time_seconds)) {
+            if (Ball::CheckCollision(ball, another_ball, step_seconds)) {
               Ball::Bounce(ball, another_ball);
               if (ball == balls_[kCueBallIndex]) {
                 HitStatus hit_status =
                     current_player_->HitBall(another_ball->GetColor());
                 if (hit_status == HitStatus::FAULT_OPPONENT ||
                     hit_status == HitStatus::FAULT_BLACK)
-                  std::cout << "Fault! You have to hit your own ball first."
-                            << std::endl;
+                  Log::Info("Fault! You have to hit your own ball first.",
+                            {{"player", current_player_->GetName()}});
               }
               break;
             }
@@ -390,7 +517,8 @@ void Game::Update(float delta_time_seconds) {
         PlaceCueBall();
       } else if (current_player_->NoneHit()) {
         current_player_->AddFault();
-        std::cout << "Fault! No balls were hit." << std::endl;
+        Log::Info("Fault! No balls were hit.",
+                  {{"player", current_player_->GetName()}});
         TogglePlayer();
         PlaceCueBall();
       } else if (current_player_->NonePotted()) {
@@ -401,11 +529,10 @@ void Game::Update(float delta_time_seconds) {
     // Check for endgame
     if (end_ && none_moving) {
       if (balls_[kCueBallIndex]->IsPotted())
-        std::cout << current_player_->GetName()
-                  << " lost by potting the cue ball with the black ball."
-                  << std::endl;
+        Log::Info(current_player_->GetName() +
+                  " lost by potting the cue ball with the black ball.");
       else
-        std::cout << current_player_->GetName() << " won." << std::endl;
+        Log::Info(current_player_->GetName() + " won.");
       EndGame();
       end_ = false;
     }
@@ -422,6 +549,96 @@ void Game::Update(float delta_time_seconds) {
       balls_[kCueBallIndex]->Reset();
   }
 
+  for (auto ball : balls_) ball->Update(step_seconds);
+
+  PublishSnapshot();
+}
+
+void Game::PublishSnapshot() {
+  TableSnapshot &snapshot = snapshots_.GetWriteBuffer();
+  snapshot.previous_balls.resize(balls_.size());
+  snapshot.balls.resize(balls_.size());
+  snapshot.ball_colors.resize(balls_.size());
+  for (size_t i = 0; i < balls_.size(); i++) {
+    snapshot.previous_balls[i] = balls_[i]->GetModelMatrix(0);
+    snapshot.balls[i] = balls_[i]->GetModelMatrix(1);
+    snapshot.ball_colors[i] = balls_[i]->GetColor();
+  }
+
+  // Change cue color to match player if colors were assigned
+  snapshot.cue_model_matrix = cue_->GetModelMatrix();
+  snapshot.cue_color = current_player_->GetColor() == glm::vec3(1)
+                           ? cue_->GetColor()
+                           : 0.5f * current_player_->GetColor();
+  snapshot.cue_offset = cue_offset_;
+  snapshot.render_cue = stage_ == GameStage::HIT_CUE_BALL;
+
+  snapshot.lamp_position = lamp_position_;
+  snapshot.render_lamp = render_lamp_;
+  snapshot.view_matrix = camera_->GetViewMatrix();
+  snapshot.projection_matrix = camera_->GetProjectionMatrix();
+
+  // Idle once the balls, cue, camera and lamp all stand still
+  bool idle = !input_applied_ && snapshot.previous_balls == snapshot.balls &&
+              snapshot.view_matrix == published_view_matrix_ &&
+              snapshot.lamp_position == published_lamp_position_;
+  snapshot.idle = idle;
+  snapshot.shot_in_progress =
+      stage_ == GameStage::VIEW_SHOT && !idle &&
+      snapshot.previous_balls != snapshot.balls;
+  input_applied_ = false;
+  published_view_matrix_ = snapshot.view_matrix;
+  published_lamp_position_ = snapshot.lamp_position;
+
+  snapshot.tick_time = GetTickTimeStamp();
+  snapshot.sequence = ++published_sequence_;
+  snapshot.input_time = pending_input_time_;
+  snapshot.input_applied_time = pending_input_applied_time_;
+  pending_input_time_ = -1;
+
+  snapshots_.Publish();
+
+  // The render thread may be waiting for input, a change from the simulation
+  // alone has to wake it up as well
+  if (was_idle_ && !idle) window->WakeUp();
+  was_idle_ = idle;
+}
+
+bool Game::IsIdle() {
+  return !benchmark_ && frame_ && frame_->idle;
+}
+
+void Game::Update(float delta_time_seconds) {
+  frame_ = &snapshots_.Acquire();
+
+  // Only the first frame drawing a snapshot shows its input for the first time
+  if (frame_->sequence != drawn_sequence_) {
+    drawn_sequence_ = frame_->sequence;
+    if (frame_->input_time >= 0)
+      LatencyTracker::MarkFrame(frame_->input_time,
+                                frame_->input_applied_time);
+  }
+
+  // The capture reads back the frames asynchronously, so recording a whole
+  // shot does not slow down the frames showing it
+  if (!record_shots_prefix_.empty() &&
+      frame_->shot_in_progress != recording_shot_) {
+    recording_shot_ = frame_->shot_in_progress;
+    if (recording_shot_)
+      FrameCapture::StartRecording(
+          record_shots_prefix_ + "_shot" + std::to_string(++recorded_shots_),
+          record_shots_format_);
+    else
+      FrameCapture::StopRecording();
+  }
+  // Balls are drawn between the last two simulation steps, their matrices
+  // only translate and scale so blending them is exact. The alpha belongs to
+  // the snapshot acquired above, a tick published since the frame started
+  // would otherwise be drawn with the previous tick's alpha
+  float alpha = GetInterpolationAlpha(frame_->tick_time);
+
+  UploadFrameUniforms();
+
   glCullFace(GL_BACK);
   glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
   glClearDepth(1.0f);
@@ -429,90 +646,113 @@ void Game::Update(float delta_time_seconds) {
 
   // Render objects
   {
-    // Table
-    RenderSimpleMesh(table_, shaders[kPoolShaderName], kTableModelMatrix, 0,
-                     table_properties_, kTableColor);
-    RenderSimpleMesh(table_metal_, shaders[kPoolShaderName], kTableModelMatrix,
-                     0, metal_properties_, kMetalColor);
-    RenderSimpleMesh(table_bed_, shaders[kPoolShaderName], kTableModelMatrix, 0,
-                     velvet_properties_, kTableBedColor);
+    PROFILE_SCOPE("Render");
+
+    // Table, merged once all of its parts are loaded
+    {
+      PROFILE_SCOPE("Table");
+      GPU_PASS("Table");
+      table_batch_->Build();
+      RenderStaticBatch(
+          table_batch_, batch_shader_, kTableModelMatrix,
+          {table_properties_, metal_properties_, velvet_properties_},
+          {kTableColor, kMetalColor, kTableBedColor});
+    }
 
-    
     // Render to texture
-    // Bind shadow buffer for writing
-    shadowMapFBO.BindForWriting();
-    glViewport(0, 0, window->GetResolution().x, window->GetResolution().y);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-    glCullFace(GL_FRONT);
-    
-    // Render balls to depth
-    for (auto ball : balls_) {
-        ball->Update(delta_time_seconds);
-        RenderToDepth((Mesh*)ball, shaders[shadowShaderName],
-            ball->GetModelMatrix());
+    {
+      PROFILE_SCOPE("Shadow pass");
+      GPU_PASS("Shadow pass");
+      // Bind shadow buffer for writing
+      shadowMapFBO.BindForWriting();
+      GpuProfiler::CountStateChange();
+      glViewport(0, 0, window->GetResolution().x, window->GetResolution().y);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      glCullFace(GL_FRONT);
+
+      // Render balls to depth
+      for (size_t i = 0; i < frame_->balls.size(); i++) {
+          RenderToDepth((Mesh*)balls_[i], depth_shader_,
+              glm::mix(frame_->previous_balls[i], frame_->balls[i], alpha));
+      }
+
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+      glCullFace(GL_BACK);
     }
-    
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glCullFace(GL_BACK);
 
     // Switch back to the default buffer
     setDefaultFrameBuffer();
     // Render pass
-    glClear(GL_DEPTH_BUFFER_BIT);
-    shadowMapFBO.BindForReading(GL_TEXTURE0);
-    
-    for (auto ball : balls_) {
-        ball->Update(delta_time_seconds);
-        RenderToTexture((Mesh*)ball, shaders[kPoolShaderName],
-            ball->GetModelMatrix(), 0, ball_properties_,
-            ball->GetColor());
+    {
+      PROFILE_SCOPE("Ball pass");
+      GPU_PASS("Ball pass");
+      glClear(GL_DEPTH_BUFFER_BIT);
+      shadowMapFBO.BindForReading(GL_TEXTURE0);
+      GpuProfiler::CountStateChange();
+
+      for (size_t i = 0; i < frame_->balls.size(); i++) {
+          RenderToTexture((Mesh*)balls_[i], GetShader(pool_shader_),
+              glm::mix(frame_->previous_balls[i], frame_->balls[i], alpha),
+              0, ball_properties_, frame_->ball_colors[i]);
+      }
     }
 
-    // Cue
-    // Change cue color to match player if colors were assigned
-    glm::vec3 cue_color = current_player_->GetColor() == glm::vec3(1)
-                              ? cue_->GetColor()
-                              : 0.5f * current_player_->GetColor();
-    if (stage_ == GameStage::HIT_CUE_BALL)
-      RenderSimpleMesh((Mesh *)cue_, shaders[kPoolShaderName],
-                       cue_->GetModelMatrix(), cue_offset_, cue_properties_,
-                       cue_color);
-
-    // Lamp (light source for shader)
-    if (render_lamp_)
-      RenderSimpleMesh(lamp_, shaders[kPoolShaderName],
-                       glm::translate(glm::mat4(1), lamp_position_), 0,
-                       metal_properties_, kMetalColor);
+    {
+      PROFILE_SCOPE("Cue and lamp");
+      GPU_PASS("Cue and lamp");
+
+      // Cue
+      if (frame_->render_cue)
+        RenderSimpleMesh((Mesh *)cue_, GetShader(pool_shader_),
+                         frame_->cue_model_matrix, frame_->cue_offset,
+                         cue_properties_, frame_->cue_color);
+
+      // Lamp (light source for shader)
+      if (frame_->render_lamp)
+        RenderSimpleMesh(lamp_, GetShader(pool_shader_),
+                         glm::translate(glm::mat4(1), frame_->lamp_position),
+                         0, metal_properties_, kMetalColor);
+    }
   }
+
+  frame_uniforms_.EndFrame();
 }
 
 void Game::FrameEnd() {
   //DrawCoordinatSystem(camera_->GetViewMatrix(), camera_->GetProjectionMatrix());
+
+  if (dynamic_resolution_) {
+    PROFILE_SCOPE("Upscale");
+    GPU_PASS("Upscale");
+    dynamic_resolution_->Resolve(window->GetFramebuffer());
+  }
+
+  if (benchmark_) {
+    benchmark_->EndFrame();
+    if (benchmark_->IsDone()) {
+      benchmark_->WriteReport();
+      window->Close();
+    }
+  }
 }
 
 void Game::RenderSimpleMesh(Mesh *mesh, Shader *shader,
                             const glm::mat4 &model_matrix, float z_offset,
                             MaterialProperties properties,
                             const glm::vec3 &color) {
-  if (!mesh || !shader || !shader->GetProgramID()) return;
+  if (!mesh || !mesh->IsLoaded() || !shader || !shader->GetProgramID())
+    return;
 
   // Render an object using the specified shader and the specified position
   glUseProgram(shader->program);
 
-  // Set shader uniforms for light & material properties
-  GLint light_loc = glGetUniformLocation(shader->program, "light_position");
-  glUniform3fv(light_loc, 1, glm::value_ptr(lamp_position_));
-
+  // Set shader uniforms for material properties, the view, projection and
+  // light come from the Frame block
   GLint shininess_loc =
       glGetUniformLocation(shader->program, "material_shininess");
   glUniform1i(shininess_loc, properties.shininess);
 
-  GLint eye_position_loc =
-      glGetUniformLocation(shader->program, "eye_position");
-  glm::vec3 eye_position = glm::vec3(0, 0, 0);
-  glUniform3fv(eye_position_loc, 1, glm::value_ptr(eye_position));
-
   GLint kd_loc = glGetUniformLocation(shader->program, "material_kd");
   glUniform1f(kd_loc, properties.kd);
 
@@ -530,35 +770,68 @@ void Game::RenderSimpleMesh(Mesh *mesh, Shader *shader,
   glUniformMatrix4fv(model_matrix_loc, 1, GL_FALSE,
                      glm::value_ptr(model_matrix));
 
-  // Bind view matrix
-  glm::mat4 view_matrix = camera_->GetViewMatrix();
-  int view_matrix_loc = glGetUniformLocation(shader->program, "View");
-  glUniformMatrix4fv(view_matrix_loc, 1, GL_FALSE, glm::value_ptr(view_matrix));
-
-  // Bind projection matrix
-  glm::mat4 projection_matrix = camera_->GetProjectionMatrix();
-  int loc_projection_matrix =
-      glGetUniformLocation(shader->program, "Projection");
-  glUniformMatrix4fv(loc_projection_matrix, 1, GL_FALSE,
-                     glm::value_ptr(projection_matrix));
-
   // Draw the object
   glBindVertexArray(mesh->GetBuffers()->VAO);
+  GpuProfiler::CountStateChange(2);
+  GpuProfiler::CountDraw(mesh->GetDrawMode(), mesh->indices.size());
   glDrawElements(mesh->GetDrawMode(), static_cast<int>(mesh->indices.size()),
                  GL_UNSIGNED_SHORT, 0);
 }
 
+void Game::RenderStaticBatch(const StaticBatch *batch, Shader *shader,
+                             const glm::mat4 &model_matrix,
+                             const std::vector<MaterialProperties> &properties,
+                             const std::vector<glm::vec3> &colors) {
+  if (!batch || !batch->IsBuilt() || !shader || !shader->GetProgramID())
+    return;
+
+  glUseProgram(shader->program);
+
+  // Uniforms shared by all materials of the batch
+  GLint z_offset_loc = glGetUniformLocation(shader->program, "z_offset");
+  glUniform1f(z_offset_loc, 0);
+
+  // Per-material arrays, indexed by the material index of each vertex
+  std::vector<GLint> shininess;
+  std::vector<float> kd, ks;
+  for (auto &material : properties) {
+    shininess.push_back(material.shininess);
+    kd.push_back(material.kd);
+    ks.push_back(material.ks);
+  }
+  GLsizei count = static_cast<GLsizei>(properties.size());
+  glUniform1iv(glGetUniformLocation(shader->program, "batch_shininess"), count,
+               shininess.data());
+  glUniform1fv(glGetUniformLocation(shader->program, "batch_kd"), count,
+               kd.data());
+  glUniform1fv(glGetUniformLocation(shader->program, "batch_ks"), count,
+               ks.data());
+  glUniform3fv(glGetUniformLocation(shader->program, "batch_color"),
+               static_cast<GLsizei>(colors.size()),
+               glm::value_ptr(colors[0]));
+
+  // Bind model matrix
+  GLint model_matrix_loc = glGetUniformLocation(shader->program, "Model");
+  glUniformMatrix4fv(model_matrix_loc, 1, GL_FALSE,
+                     glm::value_ptr(model_matrix));
+
+  // One multi-draw for every part of the batch
+  GpuProfiler::CountStateChange();
+  batch->Render();
+}
+
 void Game::RenderToTexture(Mesh* mesh, Shader* shader, 
                            const glm::mat4& model_matrix, float z_offset, 
                            MaterialProperties properties, const glm::vec3& color)
 {
-    if (!mesh || !shader || !shader->GetProgramID()) return;
+    if (!mesh || !mesh->IsLoaded() || !shader || !shader->GetProgramID())
+        return;
     // Render an object using the specified shader	
     glUseProgram(shader->program);
 
     // Set shader uniforms for light & material properties
     GLint light_loc = glGetUniformLocation(shader->program, "light_position");
-    glUniform3fv(light_loc, 1, glm::value_ptr(lamp_position_));
+    glUniform3fv(light_loc, 1, glm::value_ptr(frame_->lamp_position));
 
     GLint shininess_loc =
         glGetUniformLocation(shader->program, "material_shininess");
@@ -586,11 +859,11 @@ void Game::RenderToTexture(Mesh* mesh, Shader* shader,
     glUniformMatrix4fv(model_matrix_loc, 1, GL_FALSE,
         glm::value_ptr(model_matrix));
     // Bind view matrix
-    glm::mat4 view_matrix = camera_->GetViewMatrix();
+    glm::mat4 view_matrix = frame_->view_matrix;
     int view_matrix_loc = glGetUniformLocation(shader->program, "View");
     glUniformMatrix4fv(view_matrix_loc, 1, GL_FALSE, glm::value_ptr(view_matrix));
     // Bind projection matrix
-    glm::mat4 projection_matrix = camera_->GetProjectionMatrix();
+    glm::mat4 projection_matrix = frame_->projection_matrix;
     int loc_projection_matrix =
         glGetUniformLocation(shader->program, "Projection");
     glUniformMatrix4fv(loc_projection_matrix, 1, GL_FALSE,
@@ -610,13 +883,38 @@ void Game::RenderToTexture(Mesh* mesh, Shader* shader,
     //glUniform1i(GL_TEXTURE1, 1);
     // Draw the object	
     glBindVertexArray(mesh->GetBuffers()->VAO);
+    GpuProfiler::CountStateChange(2);
+    GpuProfiler::CountDraw(mesh->GetDrawMode(), mesh->indices.size());
     glDrawElements(mesh->GetDrawMode(), static_cast<int>(mesh->indices.size()),
         GL_UNSIGNED_SHORT, 0);
 }
 
+void Game::UploadFrameUniforms() {
+  // Waits only when the GPU still reads the region from FRAME_REGIONS frames
+  // ago
+  frame_uniforms_.BeginFrame();
+
+  size_t offset = 0;
+  FrameUniforms *uniforms = static_cast<FrameUniforms *>(
+      frame_uniforms_.Allocate(sizeof(FrameUniforms),
+                               uniform_buffer_alignment_, offset));
+  if (!uniforms) return;
+
+  uniforms->view = frame_->view_matrix;
+  uniforms->projection = frame_->projection_matrix;
+  uniforms->light_position = glm::vec4(frame_->lamp_position, 1);
+  uniforms->eye_position = glm::vec4(0, 0, 0, 1);
+  frame_uniforms_.Flush();
+
+  glBindBufferRange(GL_UNIFORM_BUFFER, kFrameUniformsBinding,
+                    frame_uniforms_.GetBufferID(), offset,
+                    sizeof(FrameUniforms));
+}
+
 void Game::RenderToDepth(Mesh* mesh, Shader* shader, const glm::mat4& model_matrix)
 {
-    if (!mesh || !shader || !shader->GetProgramID()) return;
+    if (!mesh || !mesh->IsLoaded() || !shader || !shader->GetProgramID())
+        return;
     // Render an object using the specified shader	
     glUseProgram(shader->program);
     // Send uniform texture to shader
@@ -638,6 +936,8 @@ void Game::RenderToDepth(Mesh* mesh, Shader* shader, const glm::mat4& model_matr
         glm::value_ptr(light_projection_matrix));
     // Draw the object	
     glBindVertexArray(mesh->GetBuffers()->VAO);
+    GpuProfiler::CountStateChange(2);
+    GpuProfiler::CountDraw(mesh->GetDrawMode(), mesh->indices.size());
     glDrawElements(mesh->GetDrawMode(), static_cast<int>(mesh->indices.size()),
         GL_UNSIGNED_SHORT, 0);
 }
@@ -647,31 +947,120 @@ glm::mat4 Game::computeLightViewMatrix()
     glm::mat4 lightView;
     glm::vec3 center = glm::vec3(0.0);
     glm::vec3 up = glm::vec3(0.0, 1.0, 0.0);
-    lightView = glm::lookAt(lamp_position_, center, up);
+    lightView = glm::lookAt(frame_->lamp_position, center, up);
     return lightView;
 }
 
 #pragma region INPUT UPDATE
 
 void Game::OnInputUpdate(float delta_time, int mods) {
-  if (!window->MouseHold(GLFW_MOUSE_BUTTON_RIGHT)) {
-    if (mods == GLFW_MOD_CONTROL) {
+  InputEvent event = {};
+  event.type = InputEvent::Type::UPDATE;
+  event.delta_time = delta_time;
+  event.mods = mods;
+
+  const std::pair<int, unsigned int> keys[] = {
+      {GLFW_KEY_W, InputEvent::kHeldW}, {GLFW_KEY_A, InputEvent::kHeldA},
+      {GLFW_KEY_S, InputEvent::kHeldS}, {GLFW_KEY_D, InputEvent::kHeldD},
+      {GLFW_KEY_E, InputEvent::kHeldE}, {GLFW_KEY_Q, InputEvent::kHeldQ}};
+  for (auto &key : keys)
+    if (window->KeyHold(key.first)) event.held |= key.second;
+  if (window->MouseHold(GLFW_MOUSE_BUTTON_LEFT))
+    event.held |= InputEvent::kHeldLeftMouse;
+  if (window->MouseHold(GLFW_MOUSE_BUTTON_RIGHT))
+    event.held |= InputEvent::kHeldRightMouse;
+
+  // Nothing to apply without a key or button held, skipping the event keeps
+  // the simulation idle
+  if (event.held) PushInput(event);
+}
+
+void Game::OnKeyPress(int key, int mods) {
+  InputEvent event = {};
+  event.type = InputEvent::Type::KEY_PRESS;
+  event.key = key;
+  event.mods = mods;
+  PushInput(event);
+}
+
+void Game::OnKeyRelease(int key, int mods) {}
+
+void Game::OnMouseMove(int mouse_x, int mouse_y, int delta_x, int delta_y) {
+  // Mouse moves only matter while the right button is held
+  if (!window->MouseHold(GLFW_MOUSE_BUTTON_RIGHT)) return;
+
+  InputEvent event = {};
+  event.type = InputEvent::Type::MOUSE_MOVE;
+  event.held = InputEvent::kHeldRightMouse;
+  event.time = window->GetMouseMoveTime();
+  event.delta_x = delta_x;
+  event.delta_y = delta_y;
+  PushInput(event);
+}
+
+void Game::OnMouseBtnPress(int mouse_x, int mouse_y, int button, int mods) {}
+
+void Game::OnMouseBtnRelease(int mouse_x, int mouse_y, int button, int mods) {
+  InputEvent event = {};
+  event.type = InputEvent::Type::MOUSE_RELEASE;
+  event.button = button;
+  event.mods = mods;
+  PushInput(event);
+}
+
+void Game::OnMouseScroll(int mouse_x, int mouse_y, int offset_x, int offset_y) {
+}
+
+void Game::OnWindowResize(int width, int height) {}
+
+void Game::PushInput(const InputEvent &event) {
+  // The simulation drains the queue every tick, it only fills up when the
+  // simulation is stalled and the input is stale by then anyway
+  input_queue_.TryPush(event);
+}
+
+void Game::ApplyInput(const InputEvent &event) {
+  input_applied_ = true;
+  switch (event.type) {
+    case InputEvent::Type::UPDATE:
+      ApplyInputUpdate(event);
+      break;
+    case InputEvent::Type::KEY_PRESS:
+      ApplyKeyPress(event);
+      break;
+    case InputEvent::Type::MOUSE_MOVE:
+      ApplyMouseMove(event);
+      break;
+    case InputEvent::Type::MOUSE_RELEASE:
+      ApplyMouseRelease(event);
+      break;
+  }
+}
+
+void Game::ApplyInputUpdate(const InputEvent &event) {
+  float delta_time = event.delta_time;
+  auto held = [&event](unsigned int input) {
+    return (event.held & input) != 0;
+  };
+
+  if (!held(InputEvent::kHeldRightMouse)) {
+    if (event.mods == GLFW_MOD_CONTROL) {
       // Control light position using CTRL + W, A, S, D, E, Q
       glm::vec3 up = glm::vec3(0, 1, 0);
       glm::vec3 right = glm::vec3(1, 0, 0);
       glm::vec3 forward = glm::vec3(0, 0, 1);
 
-      if (window->KeyHold(GLFW_KEY_W))
+      if (held(InputEvent::kHeldW))
         lamp_position_ -= forward * delta_time * kMovementSpeed;
-      if (window->KeyHold(GLFW_KEY_A))
+      if (held(InputEvent::kHeldA))
         lamp_position_ -= right * delta_time * kMovementSpeed;
-      if (window->KeyHold(GLFW_KEY_S))
+      if (held(InputEvent::kHeldS))
         lamp_position_ += forward * delta_time * kMovementSpeed;
-      if (window->KeyHold(GLFW_KEY_D))
+      if (held(InputEvent::kHeldD))
         lamp_position_ += right * delta_time * kMovementSpeed;
-      if (window->KeyHold(GLFW_KEY_E))
+      if (held(InputEvent::kHeldE))
         lamp_position_ += up * delta_time * kMovementSpeed;
-      if (window->KeyHold(GLFW_KEY_Q))
+      if (held(InputEvent::kHeldQ))
         lamp_position_ -= up * delta_time * kMovementSpeed;
     } else if (stage_ == GameStage::PLACE_CUE_BALL ||
                stage_ == GameStage::BREAK) {
@@ -683,47 +1072,41 @@ void Game::OnInputUpdate(float delta_time, int mods) {
                               ? kTableLength / 4
                               : -kTableLength / 2 + kBallRadius;
 
-      if (window->KeyHold(GLFW_KEY_W) && pos.z > upper_limit)
+      if (held(InputEvent::kHeldW) && pos.z > upper_limit)
         cue_ball->MoveUp(delta_time);
-      if (window->KeyHold(GLFW_KEY_A) && pos.x > -kTableWidth / 2 + kBallRadius)
+      if (held(InputEvent::kHeldA) && pos.x > -kTableWidth / 2 + kBallRadius)
         cue_ball->MoveLeft(delta_time);
-      if (window->KeyHold(GLFW_KEY_S) && pos.z < kTableLength / 2 - kBallRadius)
+      if (held(InputEvent::kHeldS) && pos.z < kTableLength / 2 - kBallRadius)
         cue_ball->MoveDown(delta_time);
-      if (window->KeyHold(GLFW_KEY_D) && pos.x < kTableWidth / 2 - kBallRadius)
+      if (held(InputEvent::kHeldD) && pos.x < kTableWidth / 2 - kBallRadius)
         cue_ball->MoveRight(delta_time);
 
       // Reverse movement if balls are touching
       for (auto ball : balls_) {
         if (cue_ball == ball || ball->IsPotted()) continue;
         if (Ball::AreTouching(cue_ball, ball)) {
-          if (window->KeyHold(GLFW_KEY_W)) cue_ball->MoveDown(delta_time);
-          if (window->KeyHold(GLFW_KEY_A)) cue_ball->MoveRight(delta_time);
-          if (window->KeyHold(GLFW_KEY_S)) cue_ball->MoveUp(delta_time);
-          if (window->KeyHold(GLFW_KEY_D)) cue_ball->MoveLeft(delta_time);
+          if (held(InputEvent::kHeldW)) cue_ball->MoveDown(delta_time);
+          if (held(InputEvent::kHeldA)) cue_ball->MoveRight(delta_time);
+          if (held(InputEvent::kHeldS)) cue_ball->MoveUp(delta_time);
+          if (held(InputEvent::kHeldD)) cue_ball->MoveLeft(delta_time);
         }
       }
     }
   } else if (stage_ == GameStage::LOOK_AROUND) {
     // Move camera using W, A, S, D, E, Q
-    if (window->KeyHold(GLFW_KEY_W)) camera_->TranslateForward(delta_time);
-    if (window->KeyHold(GLFW_KEY_A)) camera_->TranslateRight(-delta_time);
-    if (window->KeyHold(GLFW_KEY_S)) camera_->TranslateForward(-delta_time);
-    if (window->KeyHold(GLFW_KEY_D)) camera_->TranslateRight(delta_time);
-    if (window->KeyHold(GLFW_KEY_Q)) camera_->TranslateUpword(-delta_time);
-    if (window->KeyHold(GLFW_KEY_E)) camera_->TranslateUpword(delta_time);
+    if (held(InputEvent::kHeldW)) camera_->TranslateForward(delta_time);
+    if (held(InputEvent::kHeldA)) camera_->TranslateRight(-delta_time);
+    if (held(InputEvent::kHeldS)) camera_->TranslateForward(-delta_time);
+    if (held(InputEvent::kHeldD)) camera_->TranslateRight(delta_time);
+    if (held(InputEvent::kHeldQ)) camera_->TranslateUpword(-delta_time);
+    if (held(InputEvent::kHeldE)) camera_->TranslateUpword(delta_time);
   }
 
-  if (window->MouseHold(GLFW_MOUSE_BUTTON_LEFT)) {
-    // Move cue closer/further from the ball to choose shot intensity
-    cue_offset_ += cue_movement_speed_ * delta_time;
-    if (cue_offset_ > kMaxCueOffset) cue_offset_ = kMaxCueOffset;
-    if (cue_offset_ < 0) cue_offset_ = 0;
-    if (cue_offset_ == kMaxCueOffset || cue_offset_ == 0)
-      cue_movement_speed_ *= -1;
-  }
 }
 
-void Game::OnKeyPress(int key, int mods) {
+void Game::ApplyKeyPress(const InputEvent &event) {
+  int key = event.key;
+
   // Press SPACE to start shot if cue ball isn't moving
   if (key == GLFW_KEY_SPACE && (stage_ != GameStage::HIT_CUE_BALL) &&
       !balls_[kCueBallIndex]->IsMoving() && press_space_to_continue_)
@@ -739,27 +1122,35 @@ void Game::OnKeyPress(int key, int mods) {
   if (key == GLFW_KEY_H) Help();
 }
 
-void Game::OnKeyRelease(int key, int mods) {}
+void Game::ApplyMouseMove(const InputEvent &event) {
+  if (stage_ != GameStage::HIT_CUE_BALL && stage_ != GameStage::LOOK_AROUND)
+    return;
 
-void Game::OnMouseMove(int mouse_x, int mouse_y, int delta_x, int delta_y) {
-  if (window->MouseHold(GLFW_MOUSE_BUTTON_RIGHT)) {
-    if (stage_ == GameStage::HIT_CUE_BALL) {
-      // Move cue and camera left and right
-      camera_->RotateOy((float)-delta_x * kSensitivity);
-      cue_->Rotate((float)-delta_x * kSensitivity);
-    }
-    if (stage_ == GameStage::LOOK_AROUND) {
-      // Move camera left/right/up/down
-      camera_->RotateOy((float)-delta_x * kSensitivity);
-      camera_->RotateOx((float)-delta_y * kSensitivity);
-    }
+  if (stage_ == GameStage::HIT_CUE_BALL) {
+    // Move cue and camera left and right
+    camera_->RotateOy((float)-event.delta_x * kSensitivity);
+    cue_->Rotate((float)-event.delta_x * kSensitivity);
+  }
+  if (stage_ == GameStage::LOOK_AROUND) {
+    // Move camera left/right/up/down
+    camera_->RotateOy((float)-event.delta_x * kSensitivity);
+    camera_->RotateOx((float)-event.delta_y * kSensitivity);
+  }
+
+  // The next snapshot is the first to show this move
+  if (LatencyTracker::IsEnabled() &&
+      (pending_input_time_ < 0 || event.time < pending_input_time_)) {
+    pending_input_time_ = event.time;
+    pending_input_applied_time_ = Engine::GetElapsedTime();
   }
 }
 
-void Game::OnMouseBtnPress(int mouse_x, int mouse_y, int button, int mods) {}
+void Game::ApplyMouseRelease(const InputEvent &event) {
+  // The release sample is recorded before the event, but may have arrived
+  // after this tick read the samples
+  ApplyInputSamples();
 
-void Game::OnMouseBtnRelease(int mouse_x, int mouse_y, int button, int mods) {
-  if (button == 1 &&  // GLFW_MOUSE_BUTTON_LEFT not working?
+  if (event.button == 1 &&  // GLFW_MOUSE_BUTTON_LEFT not working?
       cue_offset_ >= 0 && stage_ == GameStage::HIT_CUE_BALL) {
     // Release LEFT_MOUSE_BUTTON to hit cue ball
     balls_[kCueBallIndex]->CueHit(cue_->GetDirection(), -cue_offset_);
@@ -767,24 +1158,52 @@ void Game::OnMouseBtnRelease(int mouse_x, int mouse_y, int button, int mods) {
   }
 }
 
-void Game::OnMouseScroll(int mouse_x, int mouse_y, int offset_x, int offset_y) {
+void Game::ApplyInputSamples() {
+  InputSample sample;
+  while (window->PopInputSample(sample)) {
+    if (sample.type != InputSample::Type::MOUSE_BUTTON ||
+        sample.code != GLFW_MOUSE_BUTTON_LEFT)
+      continue;
+
+    // Move cue closer/further from the ball to choose shot intensity
+    if (sample.action == GLFW_PRESS) {
+      stroke_active_ = true;
+      stroke_start_time_ = sample.time;
+      stroke_start_offset_ = cue_offset_;
+      stroke_start_speed_ = cue_movement_speed_;
+    } else if (sample.action == GLFW_RELEASE && stroke_active_) {
+      stroke_active_ = false;
+      cue_offset_ = GetStrokeOffset(sample.time, &cue_movement_speed_);
+    }
+  }
 }
 
-void Game::OnWindowResize(int width, int height) {}
+float Game::GetStrokeOffset(double time, float *speed) const {
+  // Unfolds the back and forth motion into a distance that only grows, one
+  // period takes the cue from 0 to kMaxCueOffset and back
+  double period = 2.0 * kMaxCueOffset;
+  double start = stroke_start_speed_ >= 0 ? stroke_start_offset_
+                                          : period - stroke_start_offset_;
+  double elapsed = std::max(time - stroke_start_time_, 0.0);
+  double distance =
+      std::fmod(start + std::abs(stroke_start_speed_) * elapsed, period);
+
+  bool forward = distance < kMaxCueOffset;
+  if (speed)
+    *speed = forward ? std::abs(stroke_start_speed_)
+                     : -std::abs(stroke_start_speed_);
+  return static_cast<float>(forward ? distance : period - distance);
+}
 
 #pragma endregion
 
 #pragma region GAME STAGES
 
 void Game::Break() {
-  std::cout << std::endl
-            << current_player_->GetName() << " is breaking. Good luck!"
-            << std::endl;
-  std::cout
-      << "Place the cue ball using the WASD keys, then press SPACE to start"
-      << std::endl
-      << "your shot. You can press H at any time to view detailed controls."
-      << std::endl;
+  Log::Info("\n" + current_player_->GetName() + " is breaking. Good luck!");
+  Log::Info(
+      "Place the cue ball using the WASD keys, then press SPACE to start\n"
+      "your shot. You can press H at any time to view detailed controls.");
 
   prev_stage_ = stage_ = GameStage::BREAK;
   camera_->TopDown();
@@ -798,9 +1217,7 @@ void Game::ViewShot() {
 
 void Game::PlaceCueBall() {
   if (print_help_[GameStage::PLACE_CUE_BALL]) {
-    std::cout << std::endl
-              << "You can place the cue ball anywhere using the WASD keys."
-              << std::endl;
+    Log::Info("\nYou can place the cue ball anywhere using the WASD keys.");
     print_help_[GameStage::PLACE_CUE_BALL] = false;
   }
 
@@ -830,15 +1247,12 @@ Ball *Game::GetClosestOwnedBall(glm::vec3 point) {
 
 void Game::HitCueBall() {
   if (print_help_[GameStage::HIT_CUE_BALL]) {
-    std::cout
-        << std::endl
-        << "Press RIGHT_MOUSE_BUTTON and move mouse to position shot"
-        << std::endl
-        << "horizontally.Press LEFT_MOUSE_BUTTON to start moving cue, release"
-        << std::endl
-        << "to hit(the further the cue is from the ball, the stronger the "
-        << std::endl
-        << "shot)." << std::endl;
+    Log::Info(
+        "\n"
+        "Press RIGHT_MOUSE_BUTTON and move mouse to position shot\n"
+        "horizontally.Press LEFT_MOUSE_BUTTON to start moving cue, release\n"
+        "to hit(the further the cue is from the ball, the stronger the \n"
+        "shot).");
     print_help_[GameStage::HIT_CUE_BALL] = false;
   }
 
@@ -857,15 +1271,16 @@ void Game::HitCueBall() {
   else
     cue_->Rotate((float)(-camera_->GetOxAngle() + M_PI));
   cue_offset_ = 0;
+  stroke_active_ = false;
 }
 
 void Game::LookAround() {
   if (print_help_[GameStage::LOOK_AROUND]) {
-    std::cout << std::endl
-              << "Look around using the mouse and the WASDEQ keys" << std::endl
-              << "(first-person view) by pressing RIGHT_MOUSE_BUTTON. Press V "
-              << std::endl
-              << "again to go back to the previous mode." << std::endl;
+    Log::Info(
+        "\n"
+        "Look around using the mouse and the WASDEQ keys\n"
+        "(first-person view) by pressing RIGHT_MOUSE_BUTTON. Press V \n"
+        "again to go back to the previous mode.");
     print_help_[GameStage::LOOK_AROUND] = false;
   }
 
@@ -893,9 +1308,59 @@ void Game::LookAround() {
   }
 }
 
+void Game::UpdateBenchmark() {
+  if (benchmark_->IsDone()) return;
+
+  bool scene_ready =
+      AssetLoader::GetPendingCount() == 0 && table_batch_->IsBuilt();
+  BenchmarkPhase phase = benchmark_->BeginFrame(scene_ready);
+  bool first_frame = benchmark_->GetPhaseFrame() == 0;
+
+  switch (phase) {
+    case BenchmarkPhase::TOP_DOWN:
+      // Static view of the whole table
+      if (first_frame) ViewShot();
+      break;
+    case BenchmarkPhase::THIRD_PERSON:
+      // One full turn around the cue ball, the cue follows the camera
+      if (first_frame) {
+        HitCueBall();
+      } else {
+        float angle = 2 * static_cast<float>(M_PI) /
+                      benchmark_->GetPhaseLength();
+        camera_->RotateOy(angle);
+        cue_->Rotate(angle);
+      }
+      break;
+    case BenchmarkPhase::FIRST_PERSON:
+      // Walk towards the table while looking around
+      if (first_frame) LookAround();
+      camera_->RotateOy(0.5f * Benchmark::kFixedTimeStep);
+      camera_->TranslateForward(0.5f * Benchmark::kFixedTimeStep);
+      break;
+    case BenchmarkPhase::BREAK:
+      // Full strength break, watched from above while the balls spread
+      if (first_frame) {
+        // Leaving LookAround goes back to HitCueBall, aimed at the rack
+        LookAround();
+        cue_offset_ = kMaxCueOffset;
+        balls_[kCueBallIndex]->CueHit(cue_->GetDirection(), -cue_offset_);
+        ViewShot();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
 void Game::setDefaultFrameBuffer()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // The scene goes to the scaled target, upscaled to the window in FrameEnd
+    if (dynamic_resolution_) {
+        dynamic_resolution_->Bind();
+        return;
+    }
+    window->BindFramebuffer();
     glViewport(0, 0, window->props.resolution.x, window->props.resolution.y);
 }
 
@@ -3,8 +3,15 @@
 
 #include <Component/SimpleScene.h>
 #include <Component/Transform/Transform.h>
+#include <Core/GPU/DynamicResolution.h>
+#include <Core/GPU/FrameCapture.h>
 #include <Core/GPU/Mesh.h>
+#include <Core/GPU/StaticBatch.h>
+#include <Core/GPU/StreamBuffer.h>
+#include <Core/Threading/SPSCQueue.h>
+#include <Core/Threading/TripleBuffer.h>
 
+#include "pool/game/benchmark.h"
 #include "pool/game/player.h"
 #include "pool/camera.h"
 #include "pool/objects/ball.h"
@@ -19,6 +26,62 @@ typedef struct {
 
 enum class GameStage { BREAK, PLACE_CUE_BALL, HIT_CUE_BALL, VIEW_SHOT, LOOK_AROUND };
 
+/*
+Input recorded on the render thread and applied by the simulation at the start
+of its next tick.
+*/
+struct InputEvent {
+  enum class Type { UPDATE, KEY_PRESS, MOUSE_MOVE, MOUSE_RELEASE };
+  // Keys and mouse buttons held when the event was recorded
+  enum Held : unsigned int {
+    kHeldW = 1 << 0,
+    kHeldA = 1 << 1,
+    kHeldS = 1 << 2,
+    kHeldD = 1 << 3,
+    kHeldE = 1 << 4,
+    kHeldQ = 1 << 5,
+    kHeldLeftMouse = 1 << 6,
+    kHeldRightMouse = 1 << 7
+  };
+
+  Type type;
+  unsigned int held;
+  // Engine::GetElapsedTime() of the callback behind the event, for the
+  // latency measurement
+  double time;
+  float delta_time;
+  int key, button, mods, delta_x, delta_y;
+};
+
+/*
+Everything the render thread draws, as published by one simulation tick.
+*/
+struct TableSnapshot {
+  // Ball model matrices before and after the tick, blended by the render
+  // thread
+  std::vector<glm::mat4> previous_balls, balls;
+  std::vector<glm::vec3> ball_colors;
+  glm::mat4 cue_model_matrix;
+  glm::vec3 cue_color;
+  float cue_offset;
+  bool render_cue;
+  glm::vec3 lamp_position;
+  bool render_lamp;
+  glm::mat4 view_matrix, projection_matrix;
+  // Nothing moved and no input arrived during the tick
+  bool idle;
+  // Balls are still rolling after a shot
+  bool shot_in_progress;
+  // World::GetTickTimeStamp of the tick that produced the snapshot, the
+  // render thread blends it with GetInterpolationAlpha(tick_time)
+  double tick_time;
+  // Counts the published snapshots, the render thread tells new ones apart
+  unsigned int sequence;
+  // Oldest input whose effect this snapshot is the first to show and when the
+  // simulation applied it, input_time < 0 without any
+  double input_time, input_applied_time;
+};
+
 class Game : public SimpleScene {
  public:
   Game();
@@ -32,21 +95,44 @@ class Game : public SimpleScene {
   void TogglePlayer();
   void Help();
 
+  // Runs the scripted benchmark instead of a game, the game takes ownership
+  // of benchmark. Must be set before Init
+  void SetBenchmark(Benchmark *benchmark);
+  // Renders the scene at a resolution scaled to keep the GPU frame time under
+  // milliseconds, 0 always renders at the window resolution. Must be set
+  // before Init
+  void SetTargetFrameTime(double milliseconds);
+  // Records every shot, from the hit until the balls stop, as prefix_shotN in
+  // format. An empty prefix records nothing
+  void SetRecordShots(const std::string &prefix, FrameCapture::Format format);
+
  private:
   void FrameStart() override;
+  void FixedUpdate(float step_seconds) override;
   void Update(float delta_time_seconds) override;
   void FrameEnd() override;
+  bool IsIdle() override;
 
   void RenderSimpleMesh(Mesh *mesh, Shader *shader,
                         const glm::mat4 &model_matrix, float z_offset,
                         MaterialProperties properties,
                         const glm::vec3 &color = glm::vec3(1));
+  // Draws a batch built from meshes sharing model_matrix, material i of the
+  // batch uses properties[i] and colors[i]
+  void RenderStaticBatch(const StaticBatch *batch, Shader *shader,
+                         const glm::mat4 &model_matrix,
+                         const std::vector<MaterialProperties> &properties,
+                         const std::vector<glm::vec3> &colors);
   void RenderToDepth(Mesh* mesh, Shader* shader, const glm::mat4& model_matrix);
+  // Writes the Frame uniform block (pool/shaders/Frame.glsl) of this frame
+  // to kFrameUniformsBinding, the pool shader binds its block there
+  void UploadFrameUniforms();
   void RenderToTexture(Mesh* mesh, Shader* shader,
                        const glm::mat4& model_matrix, float z_offset,
                        MaterialProperties properties,
                        const glm::vec3& color = glm::vec3(1));
 
+  // Input handlers only record events, ApplyInput runs them on the simulation
   void OnInputUpdate(float delta_time, int mods) override;
   void OnKeyPress(int key, int mods) override;
   void OnKeyRelease(int key, int mods) override;
@@ -57,7 +143,21 @@ class Game : public SimpleScene {
   void OnMouseScroll(int mouse_x, int mouse_y, int offset_x,
                      int offset_y) override;
   void OnWindowResize(int width, int height) override;
-  
+
+  void PushInput(const InputEvent &event);
+  void ApplyInput(const InputEvent &event);
+  void ApplyInputUpdate(const InputEvent &event);
+  void ApplyKeyPress(const InputEvent &event);
+  void ApplyMouseMove(const InputEvent &event);
+  void ApplyMouseRelease(const InputEvent &event);
+  // Reads the timestamped button samples of the window, they time the strokes
+  void ApplyInputSamples();
+  // Cue offset reached time seconds into the current stroke, speed receives
+  // the direction the cue moves in by then
+  float GetStrokeOffset(double time, float *speed = nullptr) const;
+  // Hands the state of the last tick to the render thread
+  void PublishSnapshot();
+
   Ball* GetClosestOwnedBall(glm::vec3 point);
 
   /*
@@ -87,6 +187,10 @@ class Game : public SimpleScene {
   WASDEQ keys (first-person view) by pressing RIGHT_MOUSE_BUTTON.
   */
   void LookAround();
+  /*
+  Moves the camera along the path of the current benchmark phase.
+  */
+  void UpdateBenchmark();
   void setDefaultFrameBuffer();
   /*
   Computes the View Matrix of the light.
@@ -109,15 +213,24 @@ class Game : public SimpleScene {
   static const std::string kPoolShaderName;
   static const std::string shadowShaderName;
   static const std::string renderToTextureShaderName;
+  static const GLuint kFrameUniformsBinding;
 #pragma endregion
 
+  // Camera, ball, cue and lamp transforms and the game elements belong to the
+  // simulation (the simulation thread when there is one), the render thread
+  // only sees them through snapshots_. Meshes, batches and shaders are used
+  // by the render thread only
+
   // 3D scene elements
 
   Camera *camera_;
   Mesh *table_, *table_bed_, *table_metal_, *lamp_;
+  StaticBatch *table_batch_;
   Cue *cue_;
   std::vector<Ball *> balls_;
   std::vector<Ball *> pockets_;
+  ShaderHandle pool_shader_, shadow_shader_;
+  Shader *depth_shader_, *batch_shader_;
 
   // Object properties
 
@@ -126,6 +239,12 @@ class Game : public SimpleScene {
   glm::vec3 lamp_position_;
   bool render_lamp_;
   float cue_offset_, cue_movement_speed_;
+  // The cue moves back and forth while the left button is held. Its offset is
+  // computed from the press and release timestamps instead of being summed up
+  // per frame, so the same hold gives the same shot at any frame rate
+  bool stroke_active_;
+  double stroke_start_time_;
+  float stroke_start_offset_, stroke_start_speed_;
 
   // Game elements
 
@@ -134,6 +253,36 @@ class Game : public SimpleScene {
   Player *current_player_;
   std::unordered_map<GameStage, bool> print_help_;
   bool press_space_to_continue_, end_;
+
+  // Idle detection, compared against the previous tick
+  bool input_applied_, was_idle_;
+  glm::mat4 published_view_matrix_;
+  glm::vec3 published_lamp_position_;
+
+  // Latency measurement, the oldest input applied since the last snapshot
+  unsigned int published_sequence_, drawn_sequence_;
+  double pending_input_time_, pending_input_applied_time_;
+
+  // Render state
+
+  TripleBuffer<TableSnapshot> snapshots_;
+  SPSCQueue<InputEvent, 256> input_queue_;
+  // Snapshot drawn by the current frame
+  const TableSnapshot *frame_;
+  // Frame uniform blocks, one region per frame in flight
+  StreamBuffer frame_uniforms_;
+  // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried once in Init
+  GLint uniform_buffer_alignment_;
+  // Scene target, null when rendering at the window resolution
+  DynamicResolution *dynamic_resolution_;
+  double target_frame_time_;
+  // Shot recording, started and stopped by the render thread
+  std::string record_shots_prefix_;
+  FrameCapture::Format record_shots_format_;
+  unsigned int recorded_shots_;
+  bool recording_shot_;
+
+  Benchmark *benchmark_;
 };
 }  // namespace pool
 
@@ -1,5 +1,7 @@
 #include "pool/game/player.h"
 
+#include <Core/Logging/Log.h>
+
 namespace pool {
 Player::Player() { Player("Player"); }
 
@@ -82,13 +84,12 @@ PotStatus Player::PotBall(glm::vec3 ball_color) {
 }
 
 void Player::PrintStats() {
-  std::cout << std::endl
-            << name_.c_str() << "'s stats:" << std::endl
-            << "> Faults: " << faults_ << std::endl
-            << "> Owned balls potted: " << own_balls_potted_ << std::endl
-            << "> Opponent's balls potted: " << opponent_balls_potted_
-            << std::endl
-            << "> Cue balls potted: " << cue_balls_potted_ << std::endl
-            << "> Best combo: " << best_combo_ << std::endl;
+  Log::Info("\n" + name_ + "'s stats:\n" +
+            "> Faults: " + std::to_string(faults_) + "\n" +
+            "> Owned balls potted: " + std::to_string(own_balls_potted_) + "\n" +
+            "> Opponent's balls potted: " +
+            std::to_string(opponent_balls_potted_) + "\n" +
+            "> Cue balls potted: " + std::to_string(cue_balls_potted_) + "\n" +
+            "> Best combo: " + std::to_string(best_combo_));
 }
 }  // namespace pool
\ No newline at end of file
@@ -1,7 +1,7 @@
 #ifndef POOL_PLAYER_H_
 #define POOL_PLAYER_H_
 
-#include <iostream>
+#include <string>
 
 #include <include/glm.h>
 
@@ -1,14 +1,24 @@
 #include "pool/objects/ball.h"
 
 #include <algorithm>
+#include <cmath>
 
+#include <Core/Managers/AssetLoader.h>
 #include <Core/Managers/ResourcePath.h>
 
 namespace pool {
+namespace {
+// Friction was tuned as a factor per step at this rate, other tick rates
+// apply it per second instead so that shots travel the same distance
+const float kFrictionTickRate = 120.0f;
+const float kFrictionPerTick = 0.99f;
+}  // namespace
+
 Ball::Ball(std::string name, glm::vec3 center, float radius, glm::vec3 color)
     : Mesh(name) {
   {
-    LoadMesh(RESOURCE_PATH::MODELS + "Primitives", "sphere.obj");
+    AssetLoader::LoadMesh(this, RESOURCE_PATH::MODELS + "Primitives",
+                          "sphere.obj");
     center_ = initial_center_ = center;
     color_ = color;
     radius_ = radius;
@@ -16,17 +26,21 @@ Ball::Ball(std::string name, glm::vec3 center, float radius, glm::vec3 color)
     model_matrix_ = glm::translate(model_matrix_, center);
     scale_ = initial_scale_ = glm::vec3(radius / kDefaultRadius);
     model_matrix_ = glm::scale(model_matrix_, scale_);
+    SnapPreviousState();
   }
 }
 
 Ball::~Ball(){};
 
 void Ball::Update(float delta_time) {
+  SnapPreviousState();
+
   glm::vec3 movement = delta_time * movement_vector_;
   center_ += movement;
   UpdateModelMatrix();
 
-  movement_vector_ *= 0.99;
+  movement_vector_ *=
+      std::pow(kFrictionPerTick, delta_time * kFrictionTickRate);
   if (abs(movement_vector_.x) < 0.1 && abs(movement_vector_.z) < 0.1) {
     movement_vector_ = glm::vec3(0, 0, 0);
   }
@@ -37,30 +51,49 @@ void Ball::Reset() {
   scale_ = initial_scale_;
   potted_ = false;
   UpdateModelMatrix();
+  SnapPreviousState();
+}
+
+glm::mat4 Ball::GetModelMatrix(float alpha) {
+  glm::mat4 model_matrix = glm::translate(
+      glm::mat4(1), glm::mix(previous_center_, center_, alpha));
+  return glm::scale(model_matrix, glm::mix(previous_scale_, scale_, alpha));
+}
+
+void Ball::SnapPreviousState() {
+  previous_center_ = center_;
+  previous_scale_ = scale_;
 }
 
 void Ball::MoveUp(float delta_time) {
   center_.z -= delta_time * kDefaultSpeed;
   UpdateModelMatrix();
+  SnapPreviousState();
 }
 
 void Ball::MoveDown(float delta_time) {
   center_.z += delta_time * kDefaultSpeed;
   UpdateModelMatrix();
+  SnapPreviousState();
 }
 
 void Ball::MoveRight(float delta_time) {
   center_.x += delta_time * kDefaultSpeed;
   UpdateModelMatrix();
+  SnapPreviousState();
 }
 
 void Ball::MoveLeft(float delta_time) {
   center_.x -= delta_time * kDefaultSpeed;
   UpdateModelMatrix();
+  SnapPreviousState();
 }
 
 void Ball::CueHit(glm::vec3 direction, float distance) {
-  movement_vector_ = direction * distance * 2.0f;
+  // A velocity in units per second, integrated over the step in Update.
+  // Balls used to move twice per 60 Hz frame, the doubled factor keeps the
+  // shot strength they had then
+  movement_vector_ = direction * distance * 4.0f;
 }
 
 void Ball::ReflectX(float offset_x) {
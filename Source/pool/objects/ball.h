@@ -9,10 +9,14 @@ class Ball : public Mesh {
   Ball(std::string name, glm::vec3 center, float radius, glm::vec3 color);
   ~Ball();
 
+  // Simulation step, keeps the state it started from for interpolation
   void Update(float delta_time);
   void Reset();
 
   inline glm::mat4 GetModelMatrix() { return model_matrix_; }
+  // Blends the state before the last Update (alpha 0) with the current one
+  // (alpha 1)
+  glm::mat4 GetModelMatrix(float alpha);
   inline glm::vec3 GetCenter() { return center_; }
   inline glm::vec3 GetColor() { return color_; }
   inline float GetRadius() { return radius_; }
@@ -49,6 +53,8 @@ class Ball : public Mesh {
 
  private:
   void UpdateModelMatrix();
+  // Moves that skip the simulation are not interpolated
+  void SnapPreviousState();
   static bool DynamicStaticCollision(Ball* ball1, Ball* ball2,
                                      float delta_time);
   static bool DynamicDynamicCollision(Ball* ball1, Ball* ball2,
@@ -60,6 +66,7 @@ class Ball : public Mesh {
   glm::vec3 color_;
   float radius_;
   glm::vec3 center_, initial_center_, scale_, initial_scale_;
+  glm::vec3 previous_center_, previous_scale_;
   glm::vec3 movement_vector_;
 
   bool potted_ = false;
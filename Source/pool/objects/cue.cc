@@ -1,5 +1,6 @@
 #include "pool/objects/cue.h"
 
+#include <Core/Managers/AssetLoader.h>
 #include <Core/Managers/ResourcePath.h>
 #include <iostream>
 
@@ -7,7 +8,7 @@ namespace pool {
 Cue::Cue(std::string name, glm::vec3 tip, float length, glm::vec3 color)
     : Mesh(name) {
   {
-    LoadMesh(RESOURCE_PATH::MODELS + "Props", "pool_cue.obj");
+    AssetLoader::LoadMesh(this, RESOURCE_PATH::MODELS + "Props", "pool_cue.obj");
     tip_ = tip;
     color_ = color;
     length = length;
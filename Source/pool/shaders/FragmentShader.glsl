@@ -10,56 +10,17 @@ in vec3 V;
 in vec3 frag_position;
 in vec3 frag_color;
 
+#ifdef STATIC_BATCH
+flat in int material_index;
+#endif
+
 // Material parameters
-uniform float material_ks;
-uniform int material_shininess;
-uniform vec3 object_color;
+#include "Material.glsl"
 uniform float z_offset;
 
-uniform vec3 light_position;
-uniform vec3 eye_position;
-
-const float PI = 3.14159265359;
-
-float DistributionGGX(vec3 N, vec3 H, float z_offset)
-{
-    float a = z_offset * z_offset;
-    float a2 = a * a;
-    float NdotH = max(dot(N, H), 0.0);
-    float NdotH2 = NdotH * NdotH;
-
-    float nom = a2;
-    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
-    denom = PI * denom * denom;
-
-    return nom / denom;
-}
-
-float GeometrySchlickGGX(float NdotV, float z_offset)
-{
-    float r = (z_offset + 1.0);
-    float k = (r * r) / 8.0;
-
-    float nom = NdotV;
-    float denom = NdotV * (1.0 - k) + k;
-
-    return nom / denom;
-}
-
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float z_offset)
-{
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-    float ggx2 = GeometrySchlickGGX(NdotV, z_offset);
-    float ggx1 = GeometrySchlickGGX(NdotL, z_offset);
-
-    return ggx1 * ggx2;
-}
+#include "Frame.glsl"
 
-vec3 fresnelSchlick(float cosTheta, vec3 F0)
-{
-    return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
-}
+#include "PBR.glsl"
 
 void main()
 {		
@@ -76,6 +37,9 @@ void main()
 	float attenuation = 1.0 / (distance * distance);
 	vec3 radiance = frag_color * attenuation;
 
+#ifdef NO_SPECULAR
+	vec3 brdf = vec3(0.0);
+#else
 	// Cook-Torrance BRDF
 	float NDF = DistributionGGX(N, H, z_offset);   
 	float G = GeometrySmith(N, V, L, z_offset);      
@@ -87,6 +51,7 @@ void main()
 	
 	// kS is equal to Fresnel
 	vec3 kS = F;
+#endif
 	
 	// For energy conservation, kD and kS can't be above 1.0 (unless the surface emits light)
 	vec3 kD = vec3(1.0) - material_ks;
@@ -0,0 +1,10 @@
+// Uniforms shared by every draw of a frame, written once per frame into a
+// stream buffer by Game::UploadFrameUniforms (std140, see FrameUniforms)
+
+layout(std140) uniform Frame
+{
+	mat4 View;
+	mat4 Projection;
+	vec3 light_position;
+	vec3 eye_position;
+};
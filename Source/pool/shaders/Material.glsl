@@ -0,0 +1,22 @@
+// Material uniforms shared by VertexShader.glsl and FragmentShader.glsl
+// With STATIC_BATCH the material comes from per-batch arrays, indexed by the
+// material_index each stage declares (vertex attribute / flat varying)
+
+#ifdef STATIC_BATCH
+#define MAX_BATCH_MATERIALS 4
+
+uniform vec3 batch_color[MAX_BATCH_MATERIALS];
+uniform float batch_kd[MAX_BATCH_MATERIALS];
+uniform float batch_ks[MAX_BATCH_MATERIALS];
+uniform int batch_shininess[MAX_BATCH_MATERIALS];
+
+#define object_color batch_color[material_index]
+#define material_kd batch_kd[material_index]
+#define material_ks batch_ks[material_index]
+#define material_shininess batch_shininess[material_index]
+#else
+uniform float material_kd;
+uniform float material_ks;
+uniform int material_shininess;
+uniform vec3 object_color;
+#endif
@@ -0,0 +1,48 @@
+// Cook-Torrance PBR terms shared by FragmentShader.glsl and Render_to_Texture_FS.glsl
+// PBR_LOW_QUALITY replaces the Smith geometry term with the implicit one (NdotV * NdotL)
+
+const float PI = 3.14159265359;
+
+float DistributionGGX(vec3 N, vec3 H, float z_offset)
+{
+    float a = z_offset * z_offset;
+    float a2 = a * a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH * NdotH;
+
+    float nom = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+
+    return nom / denom;
+}
+
+float GeometrySchlickGGX(float NdotV, float z_offset)
+{
+    float r = (z_offset + 1.0);
+    float k = (r * r) / 8.0;
+
+    float nom = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+
+    return nom / denom;
+}
+
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float z_offset)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+#ifdef PBR_LOW_QUALITY
+    return NdotV * NdotL;
+#else
+    float ggx2 = GeometrySchlickGGX(NdotV, z_offset);
+    float ggx1 = GeometrySchlickGGX(NdotL, z_offset);
+
+    return ggx1 * ggx2;
+#endif
+}
+
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+    return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
+}
@@ -4,20 +4,18 @@ layout(location = 0) in vec3 v_position;
 layout(location = 1) in vec3 v_normal;
 layout(location = 2) in vec2 v_texture_coord;
 
+#ifdef STATIC_BATCH
+layout(location = 3) in float v_material_index;
+flat out int material_index;
+#endif
+
 // Uniform properties
 uniform mat4 Model;
-uniform mat4 View;
-uniform mat4 Projection;
-
-// Uniforms for light properties
-uniform vec3 light_position;
-uniform vec3 eye_position;
-uniform float material_kd;
-uniform float material_ks;
-uniform int material_shininess;
-uniform vec3 object_color;
 uniform float z_offset;
 
+#include "Frame.glsl"
+#include "Material.glsl"
+
 // Output value to fragment shader
 out vec3 frag_position;
 out vec3 frag_color;
@@ -29,6 +27,10 @@ out vec3 V;
 
 void main()
 {
+#ifdef STATIC_BATCH
+	material_index = int(v_material_index);
+#endif
+
 	// Compute world space vectors
 	world_pos = (Model * vec4(v_position,1)).xyz;
 	N = normalize(mat3(Model) * v_normal);
@@ -1,5 +1,7 @@
 #include "ShadowMapFBO.h"
-#include <iostream>
+
+#include <Core/Logging/Log.h>
+#include <Core/Profiling/StartupReport.h>
 using namespace std;
 
 namespace pool {
@@ -23,10 +25,12 @@ namespace pool {
 		Clean();
 		// Create frame buffer object
 		glGenFramebuffers(1, &m_fbo);
+		StartupReport::AddGLObjects(StartupReport::GL_OBJECT_FRAMEBUFFER);
 		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
 
 		// Create depth texture
 		glGenTextures(1, &m_shadowMap);
+		StartupReport::AddGLObjects(StartupReport::GL_OBJECT_TEXTURE);
 		glBindTexture(GL_TEXTURE_2D, m_shadowMap);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -44,7 +48,7 @@ namespace pool {
 		// Verify fbo configuration
 		GLenum Status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 		if (Status != GL_FRAMEBUFFER_COMPLETE) {
-			cout << "FB error";
+			Log::Error("FB error");
 			return false;
 		}
 	}